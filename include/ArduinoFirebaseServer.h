@@ -1,7 +1,7 @@
 #ifndef ArduinoFirebaseServer_H
 #define ArduinoFirebaseServer_H
 
-#include "IServer.h"
+#include "IBatchServer.h"
 #include "IHttpRequest.h"
 #include <ILogger.h>
 #include <Arduino.h>
@@ -12,9 +12,10 @@
  * Firebase-style server implementation of IServer interface.
  * Header-only. Reads raw HTTP request from IArduinoRemoteStorage::GetCommand().
  * Project using this must have build_flags: -DENABLE_DATABASE -DENABLE_LEGACY_TOKEN (and optionally -DFIREBASE_SSE_TIMEOUT_MS=40000).
+ * Add -DCLOUD_PREWARM_ON_START to connect to the broker in the background on Start() rather than on the first command poll.
  */
 /* @ServerImpl("arduinofirebaseserver") */
-class ArduinoFirebaseServer : public IServer {
+class ArduinoFirebaseServer : public IBatchServer {
 
     Private UInt port_;
     Private Bool running_;
@@ -48,6 +49,27 @@ class ArduinoFirebaseServer : public IServer {
         return guid;
     }
 
+    Private IHttpRequestPtr BuildRequest(CloudCommand& command) {
+        if (command.value.empty()) {
+            //Serial.println("[ArduinoFirebaseServer] Command value empty, returning nullptr");
+            return nullptr;
+        }
+
+        StdString requestId = GenerateGuid();
+        receivedMessageCount_++;
+
+        IHttpRequestPtr req = IHttpRequest::GetRequest(requestId, RequestSource::CloudServer, command.value);
+        //Serial.print("[ArduinoFirebaseServer] Built IHttpRequest body: ");
+        //Serial.println(command.value.c_str());
+        logger->Info(Tag::Untagged, StdString("[ArduinoFirebaseServer] Received message"));
+        if (!req) {
+            logger->Error(Tag::Untagged, StdString("[ArduinoFirebaseServer] Failed to create request"));
+            //Serial.println("[ArduinoFirebaseServer] IHttpRequest::GetRequest failed");
+            return nullptr;
+        }
+        return req;
+    }
+
     Public Virtual Bool IsRunning() const override {
         return running_;
     }
@@ -92,35 +114,34 @@ class ArduinoFirebaseServer : public IServer {
             //Serial.println("[ArduinoFirebaseServer] ReceiveMessage() cloudFacade is null");
             return nullptr;
         }
-        StdString firstPair = cloudFacade->GetCommand();
-        //Serial.print("[ArduinoFirebaseServer] cloudFacade->GetCommand() returned: ");
-        //Serial.println(firstPair.c_str());
-        if (firstPair.empty()) {
+        CloudCommand command;
+        if (!cloudFacade->GetCommand(command)) {
             return nullptr;
         }
+        return BuildRequest(command);
+    }
 
-        Size colonPos = firstPair.find(':');
-        StdString value = (colonPos != StdString::npos && colonPos + 1 < firstPair.size())
-            ? firstPair.substr(colonPos + 1)
-            : firstPair;
-        if (value.empty()) {
-            //Serial.println("[ArduinoFirebaseServer] Parsed value empty, returning nullptr");
-            return nullptr;
+    Public Virtual Size ReceiveMessages(Size max, StdVector<IHttpRequestPtr>& out) override {
+        if (!cloudFacade) {
+            return 0;
         }
+        StdVector<CloudCommand> commands;
+        cloudFacade->GetCommands(max, commands);
+        Size added = 0;
+        for (CloudCommand& command : commands) {
+            IHttpRequestPtr req = BuildRequest(command);
+            if (req) {
+                out.push_back(req);
+                ++added;
+            }
+        }
+        return added;
+    }
 
-        StdString requestId = GenerateGuid();
-        receivedMessageCount_++;
-
-        IHttpRequestPtr req = IHttpRequest::GetRequest(requestId, RequestSource::CloudServer, value);
-        //Serial.print("[ArduinoFirebaseServer] Built IHttpRequest body: ");
-        //Serial.println(value.c_str());
-        logger->Info(Tag::Untagged, StdString("[ArduinoFirebaseServer] Received message"));
-        if (!req) {
-            logger->Error(Tag::Untagged, StdString("[ArduinoFirebaseServer] Failed to create request"));
-            //Serial.println("[ArduinoFirebaseServer] IHttpRequest::GetRequest failed");
-            return nullptr;
+    Public Virtual Void PrefetchMessages() override {
+        if (cloudFacade) {
+            cloudFacade->PrefetchCommands();
         }
-        return req;
     }
 
     Public Virtual Bool SendMessage(CStdString& requestId, CStdString& message) override {
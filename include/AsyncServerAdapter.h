@@ -0,0 +1,320 @@
+#ifndef AsyncServerAdapter_H
+#define AsyncServerAdapter_H
+
+#include "IAsyncServer.h"
+#include "IBatchServer.h"
+#include "IHttpRequest.h"
+#include <ILogger.h>
+#include <Arduino.h>
+#include "common/BoundedMpscQueue.h"
+#include "common/SpscRing.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+/**
+ * IAsyncServer over any IServer (HttpTcpArduinoServer, ArduinoFirebaseServer, CompositeServer), layered on
+ * the existing polling API so the wrapped server and its other callers are unchanged.
+ *
+ * An I/O task owns the server: it writes queued responses, then polls for requests into a small ring.
+ * A dispatch task sleeps on a semaphore until the I/O task hands it a request and runs the handler there,
+ * so a slow handler no longer holds up receiving and sending. Sends and receives still share the I/O task:
+ * a queued response waits while a receive blocks (e.g. HttpTcpArduinoServer reading a slow client, up to its
+ * receive timeout). Send completions run on the I/O task and should only record the result or hand it off.
+ *
+ * Stop() may be called, and the adapter destroyed, from the handler or a completion: the tasks then wind
+ * down on their own after the call returns. The state they use is shared with them, so it outlives the
+ * adapter. The wrapped server must not be used directly while the adapter is running.
+ */
+class AsyncServerAdapter : public IAsyncServer {
+    Private Static const Size kRequestRingCapacity = 8;
+    Private Static const Size kSendQueueCapacity = 8;
+    Private Static const uint32_t kIdleDelayMs = 5;
+    /** Longest the dispatch task sleeps before rechecking the stop flag. */
+    Private Static const uint32_t kDispatchWaitMs = 100;
+    /** Cloud servers run TLS on the I/O task. */
+    Private Static const uint32_t kIoTaskStackSize = 8192;
+    Private Static const uint32_t kDispatchTaskStackSize = 6144;
+
+    Private struct PendingSend {
+        StdString requestId;
+        StdString message;
+        AsyncSendCompletion completion;
+    };
+
+    /** Everything the tasks touch; each task holds a reference until it has exited. */
+    Private struct Core {
+        IServerPtr server;
+        /** Same object as server when it can drain several requests per poll. */
+        IBatchServerPtr batch;
+        AsyncRequestHandler handler;
+
+        std::atomic<bool> stopRequested{false};
+        std::atomic<int> tasksRunning{0};
+        /** True once the tasks have exited and the server was stopped (or before the first start). */
+        std::atomic<bool> finished{true};
+        std::atomic<TaskHandle_t> ioTask{nullptr};
+        std::atomic<TaskHandle_t> dispatchTask{nullptr};
+        SemaphoreHandle_t requestReady = nullptr;
+        /** I/O task to dispatch task. */
+        SpscRing<IHttpRequestPtr, kRequestRingCapacity> requests;
+        /** Any task to I/O task. */
+        BoundedMpscQueue<PendingSend, kSendQueueCapacity> sends;
+        /** Guards accepting, so no send is queued after the final drain. */
+        std::mutex sendMutex;
+        Bool accepting = false;
+
+        ~Core() {
+            if (requestReady != nullptr) {
+                vSemaphoreDelete(requestReady);
+            }
+        }
+
+        Bool IsOwnTask() const {
+            TaskHandle_t current = xTaskGetCurrentTaskHandle();
+            return current == ioTask.load() || current == dispatchTask.load();
+        }
+
+        /** Writes every queued response. Returns the number written. */
+        Size FlushSends() {
+            Size done = 0;
+            PendingSend send;
+            while (sends.TryDequeue(send)) {
+                Bool ok = server->SendMessage(send.requestId, send.message);
+                if (send.completion) send.completion(send.requestId, ok);
+                send = PendingSend();
+                ++done;
+            }
+            return done;
+        }
+
+        /** Polls the server for as many requests as the ring has room for. Returns the number queued. */
+        Size PollRequests() {
+            Size room = kRequestRingCapacity - requests.SizeApprox();
+            if (room == 0 || room > kRequestRingCapacity) {
+                return 0;
+            }
+            StdVector<IHttpRequestPtr> incoming;
+            if (batch) {
+                batch->ReceiveMessages(room, incoming);
+            } else {
+                IHttpRequestPtr request = server->ReceiveMessage();
+                if (request) incoming.push_back(request);
+            }
+            for (IHttpRequestPtr& request : incoming) {
+                requests.TryPush(std::move(request));
+            }
+            if (!incoming.empty()) {
+                xSemaphoreGive(requestReady);
+            }
+            return incoming.size();
+        }
+
+        /**
+         * Fails the responses still queued, drops requests the handler never saw and stops the server, which
+         * releases whatever it still holds for them (HttpTcpArduinoServer closes their clients). They are not
+         * answered: on a cloud source a response is a publish, not something to send while shutting down.
+         */
+        Void Finish() {
+            {
+                std::lock_guard<std::mutex> lock(sendMutex);
+                accepting = false;
+            }
+            PendingSend send;
+            while (sends.TryDequeue(send)) {
+                if (send.completion) send.completion(send.requestId, false);
+            }
+            IHttpRequestPtr request;
+            while (requests.TryPop(request)) {
+            }
+            server->Stop();
+            ioTask.store(nullptr);
+            dispatchTask.store(nullptr);
+            finished.store(true);
+        }
+
+        /** Called by each task on its way out; the last one finishes the stop. */
+        Void TaskExited() {
+            if (tasksRunning.fetch_sub(1) == 1) {
+                Finish();
+            }
+        }
+    };
+
+    typedef std::shared_ptr<Core> CorePtr;
+
+    Private CorePtr core_;
+    Private Bool running_ = false;
+    /** Optional; the adapter is built by hand rather than by the container. */
+    Private ILoggerPtr logger;
+
+    Private Static Void IoTask(Void* arg) {
+        CorePtr* ref = static_cast<CorePtr*>(arg);
+        Core& core = **ref;
+        core.ioTask.store(xTaskGetCurrentTaskHandle());
+        while (!core.stopRequested.load()) {
+            Size worked = core.FlushSends();
+            worked += core.PollRequests();
+            if (worked == 0) {
+                vTaskDelay(pdMS_TO_TICKS(kIdleDelayMs));
+            } else {
+                taskYIELD();
+            }
+        }
+        core.TaskExited();
+        delete ref;
+        vTaskDelete(nullptr);
+    }
+
+    Private Static Void DispatchTask(Void* arg) {
+        CorePtr* ref = static_cast<CorePtr*>(arg);
+        Core& core = **ref;
+        core.dispatchTask.store(xTaskGetCurrentTaskHandle());
+        while (!core.stopRequested.load()) {
+            IHttpRequestPtr request;
+            if (!core.requests.TryPop(request)) {
+                xSemaphoreTake(core.requestReady, pdMS_TO_TICKS(kDispatchWaitMs));
+                continue;
+            }
+            core.handler(request);
+        }
+        core.TaskExited();
+        delete ref;
+        vTaskDelete(nullptr);
+    }
+
+    /** Asks the tasks to exit; waits for them unless called from one of them. */
+    Private Void RequestStop() {
+        {
+            std::lock_guard<std::mutex> lock(core_->sendMutex);
+            core_->accepting = false;
+        }
+        core_->stopRequested.store(true);
+        xSemaphoreGive(core_->requestReady);
+        if (core_->IsOwnTask()) {
+            return;
+        }
+        // The I/O task may be inside a blocking receive and the dispatch task inside the handler.
+        while (!core_->finished.load()) {
+            delay(10);
+        }
+    }
+
+    /**
+     * Pass the same object as @p batch when the server hands out several requests per poll
+     * (e.g. ArduinoFirebaseServer).
+     */
+    Public Explicit AsyncServerAdapter(IServerPtr server, IBatchServerPtr batch = nullptr, ILoggerPtr log = nullptr)
+        : core_(std::make_shared<Core>()), logger(log) {
+        core_->server = server;
+        core_->batch = batch;
+    }
+
+    /** Safe from the handler or a completion; the tasks then release the shared state when they exit. */
+    Public Virtual ~AsyncServerAdapter() {
+        Stop();
+    }
+
+    /** Only while stopped, including any stop still winding down on the adapter's own tasks. */
+    Public Virtual Bool OnRequest(AsyncRequestHandler handler) override {
+        if (running_ || !core_->finished.load()) {
+            return false;
+        }
+        core_->handler = handler;
+        return true;
+    }
+
+    Public Virtual Bool Start(CUInt port = DEFAULT_SERVER_PORT) override {
+        if (running_) {
+            return true;
+        }
+        if (!core_->server || !core_->handler) {
+            if (logger) logger->Error(Tag::Untagged, StdString("[AsyncServerAdapter] Start: no server or no request handler"));
+            return false;
+        }
+        if (!core_->finished.load()) {
+            // Stopped from its own task and not yet wound down.
+            return false;
+        }
+        if (core_->requestReady == nullptr) {
+            core_->requestReady = xSemaphoreCreateBinary();
+            if (core_->requestReady == nullptr) {
+                return false;
+            }
+        }
+        if (!core_->server->Start(port)) {
+            if (logger) logger->Error(Tag::Untagged, StdString("[AsyncServerAdapter] Failed to start ") + core_->server->GetId());
+            return false;
+        }
+        core_->stopRequested.store(false);
+        core_->finished.store(false);
+        core_->tasksRunning.store(2);
+        {
+            std::lock_guard<std::mutex> lock(core_->sendMutex);
+            core_->accepting = true;
+        }
+        CorePtr* dispatchRef = new CorePtr(core_);
+        if (xTaskCreate(DispatchTask, "asyncDispatch", kDispatchTaskStackSize, dispatchRef, 1, nullptr) != pdPASS) {
+            delete dispatchRef;
+            core_->tasksRunning.store(0);
+            core_->Finish();
+            if (logger) logger->Error(Tag::Untagged, StdString("[AsyncServerAdapter] Failed to start dispatch task"));
+            return false;
+        }
+        CorePtr* ioRef = new CorePtr(core_);
+        if (xTaskCreate(IoTask, "asyncIo", kIoTaskStackSize, ioRef, 1, nullptr) != pdPASS) {
+            delete ioRef;
+            // Stands in for the I/O task's exit, so the dispatch task finishes the stop.
+            core_->TaskExited();
+            RequestStop();
+            if (logger) logger->Error(Tag::Untagged, StdString("[AsyncServerAdapter] Failed to start I/O task"));
+            return false;
+        }
+        running_ = true;
+        return true;
+    }
+
+    /**
+     * Fails responses still queued (their completions get false), drops requests not yet handed to the handler
+     * and stops the server. From the handler or a completion this only requests the stop, which completes once
+     * the current callback returns.
+     */
+    Public Virtual Void Stop() override {
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        RequestStop();
+    }
+
+    Public Virtual Bool IsRunning() const override {
+        return running_;
+    }
+
+    Public Virtual Bool SendMessageAsync(CStdString& requestId, CStdString& message, AsyncSendCompletion completion = nullptr) override {
+        std::lock_guard<std::mutex> lock(core_->sendMutex);
+        if (!core_->accepting) {
+            return false;
+        }
+        if (!core_->sends.TryEnqueue(PendingSend{requestId, message, completion})) {
+            if (logger) logger->Warning(Tag::Untagged, StdString("[AsyncServerAdapter] SendMessageAsync: send queue full"));
+            return false;
+        }
+        return true;
+    }
+
+    Public Virtual IServerPtr GetServer() const override {
+        return core_->server;
+    }
+
+    /** Occupancy of the response queue, e.g. to see whether handlers outpace the network. */
+    Public QueueStats GetSendQueueStats() const {
+        return core_->sends.GetStats();
+    }
+};
+
+#endif // AsyncServerAdapter_H
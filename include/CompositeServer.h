@@ -0,0 +1,443 @@
+#ifndef CompositeServer_H
+#define CompositeServer_H
+
+#include "IBatchServer.h"
+#include "IHttpRequest.h"
+#include <ILogger.h>
+#include <Arduino.h>
+#include "common/BoundedMpscQueue.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/** Per-source counters of a CompositeServer. */
+struct CompositeSourceStats {
+    StdString id;
+    UInt weight;
+    UInt priority;
+    ULong received;
+    ULong sent;
+    QueueStats queue;
+};
+
+/**
+ * IServer over several underlying servers (e.g. HttpTcpArduinoServer and ArduinoFirebaseServer). Each source
+ * is polled on its own FreeRTOS task into its own ready queue, so a source blocking on the network never
+ * delays another. ReceiveMessage(s) merges the queues: sources with a higher priority are always served
+ * first, and sources of equal priority share by weight (stride scheduling: every request served advances
+ * the source's pass by kStride / weight, and the backlogged source with the lowest pass goes next).
+ * SendMessage is routed back to the source that produced the request id.
+ *
+ * Calls into one underlying server are serialised by that source's mutex, so a response to a source waits
+ * while its task is inside a blocking receive; other sources are unaffected. The client address of each
+ * request is captured when it is received, so GetLastClientIp/Port never wait on a source.
+ * Sources are added with AddServer while stopped and are started and stopped with the composite.
+ */
+class CompositeServer : public IBatchServer {
+    Private Static const Size kSourceQueueCapacity = 8;
+    Private Static const Size kMaxRoutes = 64;
+    Private Static const ULongLong kStride = 1ULL << 16;
+    Private Static const uint32_t kIdleDelayMs = 5;
+    /** Cloud sources run TLS on their task. */
+    Private Static const uint32_t kSourceTaskStackSize = 8192;
+
+    /** A received request with the client address its server reported for it. */
+    Private struct ReadyRequest {
+        IHttpRequestPtr request;
+        StdString clientIp;
+        UInt clientPort = 0;
+    };
+
+    Private struct Source {
+        CompositeServer* owner = nullptr;
+        Size index = 0;
+        IServerPtr server;
+        /** Same object as server when the source can drain several requests per poll. */
+        IBatchServerPtr batch;
+        UInt weight = 1;
+        UInt priority = 0;
+        UInt port = DEFAULT_SERVER_PORT;
+        std::mutex serverMutex;
+        BoundedMpscQueue<ReadyRequest, kSourceQueueCapacity> ready;
+        std::atomic<bool> stopRequested{false};
+        std::atomic<bool> taskRunning{false};
+        std::atomic<ULong> received{0};
+        std::atomic<ULong> sent{0};
+        /** Scheduler state; guarded by scheduleMutex_. */
+        ULongLong pass = 0;
+        Bool backlogged = false;
+    };
+
+    Private StdVector<std::unique_ptr<Source>> sources_;
+    Private Bool running_ = false;
+    Private UInt port_ = DEFAULT_SERVER_PORT;
+    Private StdString ipAddress_;
+    Private UInt maxMessageSize_ = 8192;
+    Private UInt receiveTimeout_ = 5000;
+    Private std::atomic<ULong> receivedMessageCount_{0};
+    Private std::atomic<ULong> sentMessageCount_{0};
+
+    Private std::mutex scheduleMutex_;
+    Private ULongLong virtualTime_ = 0;
+    /** Client of the last request handed out. */
+    Private mutable std::mutex clientInfoMutex_;
+    Private StdString lastClientIp_;
+    Private UInt lastClientPort_ = 0;
+
+    /** Request id to source index, oldest first for eviction when responses never come. */
+    Private std::mutex routesMutex_;
+    Private StdMap<StdString, Size> routes_;
+    Private std::deque<StdString> routeOrder_;
+
+    /** Optional; the composite is built by hand rather than by the container. */
+    Private ILoggerPtr logger;
+
+    Private Void AddRoute(CStdString& requestId, Size index) {
+        std::lock_guard<std::mutex> lock(routesMutex_);
+        if (routes_.find(requestId) == routes_.end()) {
+            routeOrder_.push_back(requestId);
+        }
+        routes_[requestId] = index;
+        while (routes_.size() > kMaxRoutes && !routeOrder_.empty()) {
+            routes_.erase(routeOrder_.front());
+            routeOrder_.pop_front();
+        }
+    }
+
+    /** Removes and returns the route of @p requestId. */
+    Private Bool TakeRoute(CStdString& requestId, Size& index) {
+        std::lock_guard<std::mutex> lock(routesMutex_);
+        auto it = routes_.find(requestId);
+        if (it == routes_.end()) {
+            return false;
+        }
+        index = it->second;
+        routes_.erase(it);
+        for (auto o = routeOrder_.begin(); o != routeOrder_.end(); ++o) {
+            if (*o == requestId) {
+                routeOrder_.erase(o);
+                break;
+            }
+        }
+        return true;
+    }
+
+    Private Void Publish(Source& s, IHttpRequestPtr&& request, CStdString& clientIp, UInt clientPort) {
+        if (!request) {
+            return;
+        }
+        // Route first, so a response to the request always finds its source.
+        AddRoute(request->GetRequestId(), s.index);
+        s.received.fetch_add(1);
+        ReadyRequest ready;
+        ready.request = std::move(request);
+        ready.clientIp = clientIp;
+        ready.clientPort = clientPort;
+        s.ready.TryEnqueue(std::move(ready));
+    }
+
+    /** Fills the source's ready queue. Returns the number of requests queued. */
+    Private Size PollSource(Source& s) {
+        Size room = kSourceQueueCapacity - s.ready.SizeApprox();
+        if (room == 0 || room > kSourceQueueCapacity) {
+            return 0;
+        }
+        StdVector<IHttpRequestPtr> incoming;
+        StdString clientIp;
+        UInt clientPort = 0;
+        {
+            std::lock_guard<std::mutex> lock(s.serverMutex);
+            if (s.batch) {
+                s.batch->ReceiveMessages(room, incoming);
+            } else {
+                IHttpRequestPtr request = s.server->ReceiveMessage();
+                if (request) incoming.push_back(request);
+            }
+            if (!incoming.empty()) {
+                clientIp = s.server->GetLastClientIp();
+                clientPort = s.server->GetLastClientPort();
+            }
+        }
+        for (IHttpRequestPtr& request : incoming) {
+            Publish(s, std::move(request), clientIp, clientPort);
+        }
+        return incoming.size();
+    }
+
+    Private Static Void SourceTask(Void* arg) {
+        Source* s = static_cast<Source*>(arg);
+        while (!s->stopRequested.load()) {
+            if (s->owner->PollSource(*s) == 0) {
+                vTaskDelay(pdMS_TO_TICKS(kIdleDelayMs));
+            } else {
+                taskYIELD();
+            }
+        }
+        s->taskRunning.store(false);
+        vTaskDelete(nullptr);
+    }
+
+    /** Picks the next request: highest priority first, then lowest pass among backlogged sources. */
+    Private IHttpRequestPtr Next() {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        Source* best = nullptr;
+        for (std::unique_ptr<Source>& sp : sources_) {
+            Source* s = sp.get();
+            if (s->ready.SizeApprox() == 0) {
+                s->backlogged = false;
+                continue;
+            }
+            if (!s->backlogged) {
+                // A source returning from idle starts at the current virtual time instead of cashing in idle credit.
+                if (s->pass < virtualTime_) s->pass = virtualTime_;
+                s->backlogged = true;
+            }
+            if (best == nullptr || s->priority > best->priority || (s->priority == best->priority && s->pass < best->pass)) {
+                best = s;
+            }
+        }
+        ReadyRequest ready;
+        if (best == nullptr || !best->ready.TryDequeue(ready)) {
+            return nullptr;
+        }
+        virtualTime_ = best->pass;
+        best->pass += kStride / best->weight;
+        {
+            std::lock_guard<std::mutex> clientLock(clientInfoMutex_);
+            lastClientIp_ = std::move(ready.clientIp);
+            lastClientPort_ = ready.clientPort;
+        }
+        return ready.request;
+    }
+
+    Private Void StopSources() {
+        for (std::unique_ptr<Source>& s : sources_) {
+            s->stopRequested.store(true);
+        }
+        // A task may be inside a blocking receive; let it return before stopping its server.
+        for (std::unique_ptr<Source>& s : sources_) {
+            while (s->taskRunning.load()) {
+                delay(10);
+            }
+            std::lock_guard<std::mutex> lock(s->serverMutex);
+            s->server->Stop();
+            s->ready.Clear();
+        }
+        std::lock_guard<std::mutex> lock(routesMutex_);
+        routes_.clear();
+        routeOrder_.clear();
+    }
+
+    Private Bool AddSource(IServerPtr server, IBatchServerPtr batch, UInt weight, UInt priority, UInt port) {
+        if (running_ || !server) {
+            return false;
+        }
+        std::unique_ptr<Source> s(new Source());
+        s->owner = this;
+        s->index = sources_.size();
+        s->server = server;
+        s->batch = batch;
+        s->weight = weight == 0 ? 1 : weight;
+        s->priority = priority;
+        s->port = port;
+        sources_.push_back(std::move(s));
+        return true;
+    }
+
+    Public Explicit CompositeServer(ILoggerPtr log = nullptr) : logger(log) {}
+
+    Public Virtual ~CompositeServer() {
+        Stop();
+    }
+
+    /**
+     * Adds @p server, started on @p port with the composite. Higher @p priority is served first; within a
+     * priority, sources get requests in proportion to @p weight. Only while stopped.
+     */
+    Public Bool AddServer(IServerPtr server, UInt weight = 1, UInt priority = 0, UInt port = DEFAULT_SERVER_PORT) {
+        return AddSource(server, nullptr, weight, priority, port);
+    }
+
+    /** As AddServer, for sources that hand out several requests per poll (e.g. ArduinoFirebaseServer). */
+    Public Bool AddBatchServer(IBatchServerPtr server, UInt weight = 1, UInt priority = 0, UInt port = DEFAULT_SERVER_PORT) {
+        return AddSource(server, server, weight, priority, port);
+    }
+
+    Public StdVector<CompositeSourceStats> GetSourceStats() const {
+        StdVector<CompositeSourceStats> out;
+        for (const std::unique_ptr<Source>& s : sources_) {
+            out.push_back(CompositeSourceStats{s->server->GetId(), s->weight, s->priority, s->received.load(),
+                                               s->sent.load(), s->ready.GetStats()});
+        }
+        return out;
+    }
+
+    /** Starts every source and its polling task; @p port is only reported by GetPort(), sources use their own. */
+    Public Virtual Bool Start(CUInt port = DEFAULT_SERVER_PORT) override {
+        if (running_) {
+            return true;
+        }
+        port_ = port;
+        Bool ok = true;
+        for (std::unique_ptr<Source>& s : sources_) {
+            if (!s->server->Start(s->port)) {
+                if (logger) logger->Error(Tag::Untagged, StdString("[CompositeServer] Failed to start ") + s->server->GetId());
+                ok = false;
+                continue;
+            }
+            s->stopRequested.store(false);
+            s->taskRunning.store(true);
+            if (xTaskCreate(SourceTask, "compositeSrc", kSourceTaskStackSize, s.get(), 1, nullptr) != pdPASS) {
+                s->taskRunning.store(false);
+                if (logger) logger->Error(Tag::Untagged, StdString("[CompositeServer] Failed to start task for ") + s->server->GetId());
+                ok = false;
+            }
+        }
+        running_ = true;
+        return ok;
+    }
+
+    Public Virtual Void Stop() override {
+        if (!running_) {
+            return;
+        }
+        StopSources();
+        running_ = false;
+    }
+
+    Public Virtual Bool IsRunning() const override {
+        return running_;
+    }
+
+    Public Virtual UInt GetPort() const override {
+        return port_;
+    }
+
+    Public Virtual StdString GetIpAddress() const override {
+        return ipAddress_.empty() ? StdString("0.0.0.0") : ipAddress_;
+    }
+
+    Public Virtual Bool SetIpAddress(CStdString& ip) override {
+        if (running_) {
+            return false;
+        }
+        ipAddress_ = ip;
+        return true;
+    }
+
+    /** Returns the next ready request across all sources without blocking, or nullptr. */
+    Public Virtual IHttpRequestPtr ReceiveMessage() override {
+        IHttpRequestPtr request = Next();
+        if (request) {
+            receivedMessageCount_.fetch_add(1);
+        }
+        return request;
+    }
+
+    Public Virtual Size ReceiveMessages(Size max, StdVector<IHttpRequestPtr>& out) override {
+        Size added = 0;
+        while (added < max) {
+            IHttpRequestPtr request = Next();
+            if (!request) break;
+            out.push_back(request);
+            ++added;
+        }
+        receivedMessageCount_.fetch_add(added);
+        return added;
+    }
+
+    /** Sources are polled continuously on their own tasks. */
+    Public Virtual Void PrefetchMessages() override {
+    }
+
+    Public Virtual Bool SendMessage(CStdString& requestId, CStdString& message) override {
+        Size index;
+        if (!TakeRoute(requestId, index) || index >= sources_.size()) {
+            if (logger) logger->Warning(Tag::Untagged, StdString("[CompositeServer] SendMessage: unknown request id"));
+            return false;
+        }
+        Source& s = *sources_[index];
+        Bool ok;
+        {
+            std::lock_guard<std::mutex> lock(s.serverMutex);
+            ok = s.server->SendMessage(requestId, message);
+        }
+        if (ok) {
+            s.sent.fetch_add(1);
+            sentMessageCount_.fetch_add(1);
+        }
+        return ok;
+    }
+
+    /** Client of the last request handed out, as its source reported it on receipt. */
+    Public Virtual StdString GetLastClientIp() const override {
+        std::lock_guard<std::mutex> lock(clientInfoMutex_);
+        return lastClientIp_;
+    }
+
+    Public Virtual UInt GetLastClientPort() const override {
+        std::lock_guard<std::mutex> lock(clientInfoMutex_);
+        return lastClientPort_;
+    }
+
+    Public Virtual ULong GetReceivedMessageCount() const override {
+        return receivedMessageCount_.load();
+    }
+
+    Public Virtual ULong GetSentMessageCount() const override {
+        return sentMessageCount_.load();
+    }
+
+    Public Virtual Void ResetStatistics() override {
+        receivedMessageCount_.store(0);
+        sentMessageCount_.store(0);
+        for (std::unique_ptr<Source>& s : sources_) {
+            s->received.store(0);
+            s->sent.store(0);
+        }
+    }
+
+    Public Virtual UInt GetMaxMessageSize() const override {
+        return maxMessageSize_;
+    }
+
+    /** Applied to every source. */
+    Public Virtual Bool SetMaxMessageSize(Size size) override {
+        if (running_) {
+            return false;
+        }
+        maxMessageSize_ = (size > 8192) ? 8192u : static_cast<UInt>(size);
+        for (std::unique_ptr<Source>& s : sources_) {
+            s->server->SetMaxMessageSize(size);
+        }
+        return true;
+    }
+
+    Public Virtual UInt GetReceiveTimeout() const override {
+        return receiveTimeout_;
+    }
+
+    /** Applied to every source. */
+    Public Virtual Bool SetReceiveTimeout(CUInt timeoutMs) override {
+        receiveTimeout_ = timeoutMs;
+        for (std::unique_ptr<Source>& s : sources_) {
+            std::lock_guard<std::mutex> lock(s->serverMutex);
+            s->server->SetReceiveTimeout(timeoutMs);
+        }
+        return true;
+    }
+
+    Public Virtual ServerType GetServerType() const override {
+        return ServerType::Unknown;
+    }
+
+    Public Virtual StdString GetId() const override {
+        return StdString("compositeserver");
+    }
+};
+
+#endif // CompositeServer_H
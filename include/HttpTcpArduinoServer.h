@@ -8,6 +8,11 @@
 #include <WiFiClient.h>
 #include <Arduino.h>
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "common/SpscRing.h"
 
 /**
  * Sender details structure to store client connection information
@@ -24,6 +29,12 @@ struct SenderDetails {
 /**
  * HTTP TCP Server implementation of IServer interface
  * Simple implementation using WiFiServer (tested and working)
+ *
+ * With EnableNetworkTask() (or -DHTTP_SERVER_NETWORK_TASK) accept, read and write run on a dedicated task
+ * pinned to one core. Parsed requests and outgoing responses cross between that task and the caller through
+ * single-producer/single-consumer rings, so ReceiveMessage and SendMessage never touch a socket; SendMessage
+ * then returns true once the response is queued rather than written. It never waits: if the queue is full,
+ * SendMessage closes that client unanswered and returns false.
  */
 /* @ServerImpl("arduinotcpserver") */
 class HttpTcpArduinoServer : public IServer {
@@ -33,11 +44,44 @@ class HttpTcpArduinoServer : public IServer {
     Private StdString ipAddress_;
     Private StdString lastClientIp_;
     Private UInt lastClientPort_;
-    Private ULong receivedMessageCount_;
-    Private ULong sentMessageCount_;
+    Private std::atomic<ULong> receivedMessageCount_;
+    Private std::atomic<ULong> sentMessageCount_;
     Private UInt maxMessageSize_;
     Private UInt receiveTimeout_;
     Private StdMap<StdString, SenderDetails> requestSenderMap_;
+    /** Guards requestSenderMap_; a caller whose response cannot be queued releases its client itself. */
+    Private std::mutex senderMapMutex_;
+    /** Guards lastClientIp_/lastClientPort_, which describe the request last returned by ReceiveMessage(). */
+    Private mutable std::mutex clientInfoMutex_;
+
+    /** A request with the client address it arrived from, so the last-client fields follow the caller. */
+    Private struct IncomingRequest {
+        IHttpRequestPtr request;
+        StdString clientIp;
+        UInt clientPort = 0;
+    };
+
+    Private struct OutgoingResponse {
+        StdString requestId;
+        StdString message;
+    };
+
+    Private Static const Size kRingCapacity = 8;
+    /** Wi-Fi runs on core 0; keeping socket work there leaves the application core free. */
+    Private Static const Int kDefaultNetworkCore = 0;
+    Private Static const uint32_t kNetworkTaskStackSize = 6144;
+#ifdef HTTP_SERVER_NETWORK_TASK
+    Private Bool networkTaskEnabled_ = true;
+#else
+    Private Bool networkTaskEnabled_ = false;
+#endif
+    Private Int networkCore_ = kDefaultNetworkCore;
+    Private std::atomic<bool> networkTaskStop_{false};
+    Private std::atomic<bool> networkTaskRunning_{false};
+    /** Network task to caller. */
+    Private SpscRing<IncomingRequest, kRingCapacity> inbound_;
+    /** Caller to network task. */
+    Private SpscRing<OutgoingResponse, kRingCapacity> outbound_;
 
     /* @Autowired */
     Private ILoggerPtr logger;
@@ -226,14 +270,25 @@ class HttpTcpArduinoServer : public IServer {
         logger->Info(Tag::Untagged, StdString("[HttpTcpArduinoServer] Step 3: Starting server with server_->begin()..."));
         server_->begin();
         running_ = true;
+        if (networkTaskEnabled_) {
+            networkTaskStop_.store(false);
+            networkTaskRunning_.store(true);
+            if (xTaskCreatePinnedToCore(NetworkTask, "httpNet", kNetworkTaskStackSize, this, 2, nullptr, networkCore_) != pdPASS) {
+                networkTaskRunning_.store(false);
+                logger->Error(Tag::Untagged, StdString("[HttpTcpArduinoServer] Failed to start network task, serving inline"));
+            }
+        }
         logger->Info(Tag::Untagged, StdString("[HttpTcpArduinoServer] Server started. Running: " + StdString(running_ ? "true" : "false")));
 
         logger->Info(Tag::Untagged, StdString("[HttpTcpArduinoServer] Start() completed successfully"));
         return true;
     }
 
+    /** Closes, unanswered, every client still waiting for a response. */
     Public Virtual Void Stop() override {
         if (running_) {
+            StopNetworkTask();
+            ReleaseAllSenders();
             if (server_ != nullptr) {
                 delete server_;
                 server_ = nullptr;
@@ -262,8 +317,9 @@ class HttpTcpArduinoServer : public IServer {
         return true;
     }
 
-    Public Virtual IHttpRequestPtr ReceiveMessage() override {
-        if (!running_ || server_ == nullptr) {
+    /** Accepts and reads one request on the calling task, reporting the client's address. */
+    Private IHttpRequestPtr ReceiveNow(StdString& clientIp, UInt& clientPort) {
+        if (server_ == nullptr) {
             return nullptr;
         }
         
@@ -275,8 +331,8 @@ class HttpTcpArduinoServer : public IServer {
 
         // Store client information
         IPAddress clientIP = client.remoteIP();
-        lastClientIp_ = StdString(clientIP.toString().c_str());
-        lastClientPort_ = client.remotePort();
+        clientIp = StdString(clientIP.toString().c_str());
+        clientPort = client.remotePort();
         
         // Read HTTP headers
         StdString requestHeaders = ReadHttpRequestHeaders(client);
@@ -306,8 +362,11 @@ class HttpTcpArduinoServer : public IServer {
         }
         
         // Store sender details against the GUID
-        SenderDetails senderDetails(clientPtr, lastClientIp_, lastClientPort_);
-        requestSenderMap_[requestId] = senderDetails;
+        SenderDetails senderDetails(clientPtr, clientIp, clientPort);
+        {
+            std::lock_guard<std::mutex> lock(senderMapMutex_);
+            requestSenderMap_[requestId] = senderDetails;
+        }
         
         receivedMessageCount_++;
 
@@ -319,57 +378,197 @@ class HttpTcpArduinoServer : public IServer {
         return IHttpRequest::GetRequest(requestId, RequestSource::LocalServer, fullRequest);
     }
 
-    Public Virtual Bool SendMessage(CStdString& requestId, CStdString& message) override {
-        if (!running_ || server_ == nullptr) {
+    /** Writes @p message to the request's client and closes it, on the calling task. */
+    Private Bool SendNow(CStdString& requestId, CStdString& message) {
+        if (server_ == nullptr) {
             return false;
         }
         
-        // Look up sender details from the map using requestId
-        auto it = requestSenderMap_.find(StdString(requestId));
-        if (it == requestSenderMap_.end()) {
+        // Take the client out of the map; it is closed below whatever happens
+        WiFiClient* client = TakeSender(requestId);
+        if (client == nullptr) {
             return false; // Request ID not found
         }
         
-        SenderDetails& senderDetails = it->second;
-        
         // Check if client is valid
-        if (senderDetails.client == nullptr || !senderDetails.client->connected()) {
-            // Clean up if client is invalid
-            if (senderDetails.client != nullptr) {
-                senderDetails.client->stop();
-                delete senderDetails.client;
-            }
-            requestSenderMap_.erase(it);
+        if (!client->connected()) {
+            client->stop();
+            delete client;
             return false;
         }
         
         // Send the message using the stored client
-        WiFiClient* client = senderDetails.client;
         size_t bytesSent = client->print(message.c_str());
-        if (bytesSent == 0) {
-            // Failed to send, clean up
-            client->stop();
-            delete client;
-            requestSenderMap_.erase(it);
-            return false;
-        }
         
         // Close the client after sending
         client->stop();
         delete client;
-        
-        // Remove the entry from the map after sending
-        requestSenderMap_.erase(it);
+        if (bytesSent == 0) {
+            return false;
+        }
         
         sentMessageCount_++;
         return true;
     }
 
+    /** Records the client of the request just handed to the caller. */
+    Private Void SetLastClient(CStdString& clientIp, UInt clientPort) {
+        std::lock_guard<std::mutex> lock(clientInfoMutex_);
+        lastClientIp_ = clientIp;
+        lastClientPort_ = clientPort;
+    }
+
+    /** Removes @p requestId from the map and returns its client (nullptr if unknown); the caller closes it. */
+    Private WiFiClient* TakeSender(CStdString& requestId) {
+        std::lock_guard<std::mutex> lock(senderMapMutex_);
+        auto it = requestSenderMap_.find(requestId);
+        if (it == requestSenderMap_.end()) {
+            return nullptr;
+        }
+        WiFiClient* client = it->second.client;
+        requestSenderMap_.erase(it);
+        return client;
+    }
+
+    /** Closes the client held for @p requestId without answering it. */
+    Private Void ReleaseSender(CStdString& requestId) {
+        WiFiClient* client = TakeSender(requestId);
+        if (client != nullptr) {
+            client->stop();
+            delete client;
+        }
+    }
+
+    /** Closes every client still held for a response. */
+    Private Void ReleaseAllSenders() {
+        StdMap<StdString, SenderDetails> held;
+        {
+            std::lock_guard<std::mutex> lock(senderMapMutex_);
+            held.swap(requestSenderMap_);
+        }
+        for (auto& entry : held) {
+            WiFiClient* client = entry.second.client;
+            if (client != nullptr) {
+                client->stop();
+                delete client;
+            }
+        }
+    }
+
+    Private Static Void NetworkTask(Void* arg) {
+        HttpTcpArduinoServer* self = static_cast<HttpTcpArduinoServer*>(arg);
+        while (!self->networkTaskStop_.load()) {
+            Bool worked = false;
+            // Answer first so held clients are released before new ones are accepted.
+            OutgoingResponse response;
+            while (self->outbound_.TryPop(response)) {
+                self->SendNow(response.requestId, response.message);
+                worked = true;
+            }
+            if (!self->inbound_.IsFull()) {
+                IncomingRequest incoming;
+                incoming.request = self->ReceiveNow(incoming.clientIp, incoming.clientPort);
+                if (incoming.request) {
+                    StdString requestId = incoming.request->GetRequestId();
+                    if (!self->inbound_.TryPush(std::move(incoming))) {
+                        self->ReleaseSender(requestId);
+                    }
+                    worked = true;
+                }
+            }
+            if (!worked) {
+                vTaskDelay(pdMS_TO_TICKS(1));
+            }
+        }
+        self->networkTaskRunning_.store(false);
+        vTaskDelete(nullptr);
+    }
+
+    /**
+     * Queues a response for the network task without blocking the caller. The queue can only be full while
+     * that task is inside a blocking read; the response is then not sent, the client is closed unanswered
+     * rather than left held, and false is returned.
+     */
+    Private Bool QueueResponse(CStdString& requestId, CStdString& message) {
+        if (!outbound_.TryPush(OutgoingResponse{requestId, message})) {
+            ReleaseSender(requestId);
+            logger->Warning(Tag::Untagged, StdString("[HttpTcpArduinoServer] SendMessage: response queue full, not sent, client closed"));
+            return false;
+        }
+        return true;
+    }
+
+    Private Void StopNetworkTask() {
+        if (!networkTaskRunning_.load()) {
+            return;
+        }
+        networkTaskStop_.store(true);
+        while (networkTaskRunning_.load()) {
+            delay(1);
+        }
+        // Requests nobody will answer now; close their clients.
+        IncomingRequest incoming;
+        while (inbound_.TryPop(incoming)) {
+            ReleaseSender(incoming.request->GetRequestId());
+        }
+        OutgoingResponse response;
+        while (outbound_.TryPop(response)) {
+            SendNow(response.requestId, response.message);
+        }
+    }
+
+    /**
+     * Runs socket I/O on a dedicated task pinned to @p core from the next Start(). Only while stopped.
+     * ReceiveMessage must then be called from a single task, and so must SendMessage. SendMessage only queues
+     * the response and never waits: with the queue full it closes the client unanswered and returns false.
+     */
+    Public Bool EnableNetworkTask(Bool enabled, Int core = kDefaultNetworkCore) {
+        if (running_) {
+            return false;
+        }
+        networkTaskEnabled_ = enabled;
+        networkCore_ = core;
+        return true;
+    }
+
+    Public Virtual IHttpRequestPtr ReceiveMessage() override {
+        if (!running_) {
+            return nullptr;
+        }
+        if (networkTaskRunning_.load()) {
+            IncomingRequest incoming;
+            if (!inbound_.TryPop(incoming)) {
+                return nullptr;
+            }
+            SetLastClient(incoming.clientIp, incoming.clientPort);
+            return incoming.request;
+        }
+        StdString clientIp;
+        UInt clientPort = 0;
+        IHttpRequestPtr request = ReceiveNow(clientIp, clientPort);
+        if (request) {
+            SetLastClient(clientIp, clientPort);
+        }
+        return request;
+    }
+
+    Public Virtual Bool SendMessage(CStdString& requestId, CStdString& message) override {
+        if (!running_) {
+            return false;
+        }
+        if (networkTaskRunning_.load()) {
+            return QueueResponse(requestId, message);
+        }
+        return SendNow(requestId, message);
+    }
+
     Public Virtual StdString GetLastClientIp() const override {
+        std::lock_guard<std::mutex> lock(clientInfoMutex_);
         return lastClientIp_;
     }
 
     Public Virtual UInt GetLastClientPort() const override {
+        std::lock_guard<std::mutex> lock(clientInfoMutex_);
         return lastClientPort_;
     }
 
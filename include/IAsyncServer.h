@@ -0,0 +1,47 @@
+#ifndef IAsyncServer_H
+#define IAsyncServer_H
+
+#include "IServer.h"
+#include "IHttpRequest.h"
+#include <functional>
+
+/** Called once for every request received. */
+typedef std::function<Void(IHttpRequestPtr request)> AsyncRequestHandler;
+
+/** Called once a queued response has been handed to the server; @p ok is what SendMessage returned. */
+typedef std::function<Void(CStdString& requestId, Bool ok)> AsyncSendCompletion;
+
+/**
+ * Completion-based front end for an IServer: requests are pushed to a handler as they arrive and responses
+ * complete through a callback, so the application never polls ReceiveMessage or blocks in SendMessage.
+ */
+DefineStandardPointers(IAsyncServer)
+class IAsyncServer {
+    Public Virtual ~IAsyncServer() = default;
+
+    /** Sets the handler for incoming requests. Only while stopped. */
+    Public Virtual Bool OnRequest(AsyncRequestHandler handler) = 0;
+
+    /** Starts the underlying server on @p port and begins delivering requests. */
+    Public Virtual Bool Start(CUInt port = DEFAULT_SERVER_PORT) = 0;
+
+    /**
+     * Stops delivering, fails responses still queued and stops the underlying server. Called from the request
+     * handler or a send completion, it returns at once and the stop completes when that callback returns.
+     */
+    Public Virtual Void Stop() = 0;
+
+    Public Virtual Bool IsRunning() const = 0;
+
+    /**
+     * Queues @p message as the response to @p requestId and returns immediately. @p completion, if set, is
+     * called when the send finishes. Returns false, without calling @p completion, if the send queue is full
+     * or the server is stopped.
+     */
+    Public Virtual Bool SendMessageAsync(CStdString& requestId, CStdString& message, AsyncSendCompletion completion = nullptr) = 0;
+
+    /** The wrapped server, for configuration and statistics. */
+    Public Virtual IServerPtr GetServer() const = 0;
+};
+
+#endif // IAsyncServer_H
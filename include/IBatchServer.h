@@ -0,0 +1,22 @@
+#ifndef IBatchServer_H
+#define IBatchServer_H
+
+#include "IServer.h"
+#include "IHttpRequest.h"
+
+/**
+ * IServer extension for sources that deliver requests in bursts (e.g. cloud command queues):
+ * drain several ready requests per call and overlap the next fetch with request handling.
+ */
+DefineStandardPointers(IBatchServer)
+class IBatchServer : public IServer {
+    Public Virtual ~IBatchServer() = default;
+
+    /** Appends up to @p max ready requests to @p out with at most one network poll. Returns the number appended. */
+    Public Virtual Size ReceiveMessages(Size max, StdVector<IHttpRequestPtr>& out) = 0;
+
+    /** Starts fetching the next batch in the background; a later ReceiveMessage(s) returns it without a round trip. */
+    Public Virtual Void PrefetchMessages() = 0;
+};
+
+#endif // IBatchServer_H
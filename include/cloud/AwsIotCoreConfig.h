@@ -0,0 +1,36 @@
+#ifndef AWSIOTCORECONFIG_H
+#define AWSIOTCORECONFIG_H
+
+#include <StandardDefines.h>
+#include "CloudWireFormat.h"
+#include <memory>
+
+DefineStandardPointers(AwsIotCoreConfig)
+
+/**
+ * Immutable AWS IoT Core connection config. The endpoint, thing name and PEMs are NUL-terminated views into
+ * either built-in literals or the snapshot's own storage, so they stay valid for as long as the snapshot is
+ * held; WiFiClientSecure and PubSubClient keep these pointers rather than copying them.
+ */
+struct AwsIotCoreConfig {
+    const Char* endpoint = "";
+    const Char* thingName = "";
+    const Char* caCert = "";
+    const Char* deviceCert = "";
+    const Char* privateKey = "";
+    /** Short and used as map keys, so held as strings. */
+    StdString publishTopic;
+    StdString subscribeTopic;
+    /** Publish encoding and LZSS compression for topics without an entry in the per-topic maps below. */
+    CloudWireFormat wireFormat = CloudWireFormat::Json;
+    Bool compression = false;
+    /** Per-topic overrides, keyed by topic name. */
+    StdMap<StdString, CloudWireFormat> topicWireFormats;
+    StdMap<StdString, Bool> topicCompression;
+    /** FNV-1a of the backing file, or 0 for the built-in config. */
+    uint32_t fingerprint = 0;
+    /** Backing bytes the views point into; null for the built-in config. */
+    std::unique_ptr<Char[]> storage;
+};
+
+#endif /* AWSIOTCORECONFIG_H */
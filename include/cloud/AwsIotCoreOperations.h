@@ -7,32 +7,53 @@
 #include <PubSubClient.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <atomic>
 #include "IAwsIotCoreOperations.h"
 #include "IAwsIotCoreConfigProvider.h"
+#include "MqttAckTrackingClient.h"
+#include "MqttInflightWindow.h"
+#include "MqttTopicRouter.h"
+#include "../common/CircuitBreaker.h"
+#include "../common/IDnsCache.h"
 
 /* @Component */
 class AwsIotCoreOperations : public IAwsIotCoreOperations {
     /* @Autowired */
     Private IAwsIotCoreConfigProviderPtr configProvider;
+    /* @Autowired */
+    Private IDnsCachePtr dnsCache;
 
     Private WiFiClientSecure secureClient;
+    Private MqttAckTrackingClient ackClient;
     Private PubSubClient mqttClient;
 
-    Private StdString endpoint;
-    Private StdString thingName;
-    Private StdString caCert;
-    Private StdString deviceCert;
-    Private StdString privateKey;
-    Private StdString publishTopic;
-    Private StdString subscribeTopic;
+    /** Applied config; secureClient and mqttClient hold raw pointers into it. Written under mqttMutex. */
+    Private AwsIotCoreConfigPtr config;
 
     Private Bool configured = false;
-    Private Bool wasConnected = false;
+    /** Written under mqttMutex; atomic so IsConnected() can read it without the lock. */
+    Private std::atomic<bool> wasConnected{false};
+    /** Queues behind ReceiveMessages(topicFilter), keyed by filter; filled by bufferRoutes handlers. */
     Private StdMap<StdString, StdVector<StdString>> bufferedMessages;
+    /** Per-filter cap on bufferedMessages; the oldest message is dropped to make room. */
+    Private Static constexpr Size kMaxBufferedMessages = 32;
+    Private std::atomic<ULong> droppedBufferedMessages{0};
+    Private StdMap<StdString, UInt> bufferRoutes;
+    /** Filters subscribed at the broker in the current session. */
     Private StdUnorderedSet<StdString> subscribedTopics;
+    /** Guarded by mqttMutex; dispatched from mqttClient.loop(). */
+    Private MqttTopicRouter router;
     Private SemaphoreHandle_t mqttMutex = nullptr;
 
-    Private Static AwsIotCoreOperations* activeInstance;
+    Private Static constexpr Size kInflightWindowSize = 8;
+    Private Static constexpr ULong kPubackTimeoutMs = 5000;
+    Private Static constexpr UInt kMaxPublishAttempts = 4;
+    /** QoS 1 publishes awaiting PUBACK; guarded by mqttMutex. */
+    Private MqttInflightWindow<kInflightWindowSize> inflight;
+    Private uint16_t nextPacketId = 1;
+    Private Bool resendInflight = false;
+    /** Gates broker connection attempts (DNS + TLS + CONNECT) so an unreachable broker is not redialled on every call. */
+    Private CircuitBreaker connectBreaker;
 
     Private class MqttLockGuard {
         Private SemaphoreHandle_t mutex_;
@@ -54,12 +75,6 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
         Public Bool IsLocked() const { return locked_; }
     };
 
-    Private Static Void StaticMqttCallback(Char* topic, UInt8* payload, UInt length) {
-        if (activeInstance != nullptr) {
-            activeInstance->OnMqttMessage(topic, payload, length);
-        }
-    }
-
     Private Bool HasEnoughTlsHeadroom(const Char* context) {
         // Keep a guard, but tune for this firmware's steady-state heap profile.
         constexpr UInt kMinFreeHeap = 72 * 1024;
@@ -90,18 +105,90 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
         if (topic == nullptr) {
             return;
         }
+        ////Serial.print("[AwsIotCoreOperations] Callback topic: ");
+        ////Serial.println(topic);
+        router.Dispatch(topic, payload, length);
+    }
+
+    /** Routes messages matching @p topicFilter into bufferedMessages for ReceiveMessages(). Call with mqttMutex held. */
+    Private Void EnsureBufferRoute(CStdString topicFilter) {
+        if (bufferRoutes.find(topicFilter) != bufferRoutes.end()) {
+            return;
+        }
+        StdVector<StdString>* queue = &bufferedMessages[topicFilter];
+        std::atomic<ULong>* dropped = &droppedBufferedMessages;
+        UInt id = router.Subscribe(topicFilter, [queue, dropped](const Char*, const UInt8* payload, UInt length) {
+            if (queue->size() >= kMaxBufferedMessages) {
+                queue->erase(queue->begin());
+                ++*dropped;
+            }
+            queue->emplace_back(reinterpret_cast<const Char*>(payload), length);
+        });
+        if (id != 0) {
+            bufferRoutes[topicFilter] = id;
+        }
+    }
 
-        StdString topicName(topic);
-        StdString message;
-        message.reserve(length);
-        for (UInt i = 0; i < length; ++i) {
-            message += static_cast<Char>(payload[i]);
+    /**
+     * Removes the buffering route for @p topicFilter, its queued messages and, once no other route needs it,
+     * the broker subscription. Call with mqttMutex held.
+     */
+    Private Void DropBufferRoute(CStdString topicFilter) {
+        auto route = bufferRoutes.find(topicFilter);
+        if (route == bufferRoutes.end()) {
+            return;
         }
-        ////Serial.print("[AwsIotCoreOperations] Callback topic: ");
-        ////Serial.print(topicName.c_str());
-        ////Serial.print(" payload: ");
-        ////Serial.println(message.c_str());
-        bufferedMessages[topicName].push_back(message);
+        // Unroute first: the handler holds a pointer into bufferedMessages.
+        router.Unsubscribe(route->second);
+        bufferRoutes.erase(route);
+        bufferedMessages.erase(topicFilter);
+        if (!router.HasFilter(topicFilter) && subscribedTopics.erase(topicFilter) > 0 && mqttClient.connected()) {
+            mqttClient.unsubscribe(topicFilter.c_str());
+        }
+    }
+
+    /** Subscribes every routed filter not yet subscribed in this session. Call with mqttMutex held. */
+    Private Void SubscribeRoutedFilters() {
+        for (const StdString& filter : router.Filters()) {
+            if (subscribedTopics.find(filter) != subscribedTopics.end()) {
+                continue;
+            }
+            if (mqttClient.subscribe(filter.c_str())) {
+                subscribedTopics.insert(filter);
+            } else {
+                Serial.println("[AwsIotCoreOperations] Resubscribe failed");
+            }
+        }
+    }
+
+    Private AwsIotCoreConfigPtr CurrentConfig() const {
+        return std::atomic_load(&config);
+    }
+
+    /** Points the TLS and MQTT clients at @p next; they only read it on the next handshake. */
+    Private Void ApplyConfig(const AwsIotCoreConfigPtr& next) {
+        secureClient.setCACert(next->caCert);
+        secureClient.setCertificate(next->deviceCert);
+        secureClient.setPrivateKey(next->privateKey);
+        mqttClient.setServer(next->endpoint, 8883);
+        // Release the previous snapshot only after nothing points into it any more.
+        std::atomic_store(&config, next);
+    }
+
+    /** Picks up a changed provider snapshot before redialling. Call with mqttMutex held while disconnected. */
+    Private Void ReloadConfigIfChanged() {
+        configProvider->Refresh();
+        AwsIotCoreConfigPtr latest = configProvider->GetConfig();
+        AwsIotCoreConfigPtr previous = CurrentConfig();
+        if (latest == previous) {
+            return;
+        }
+        if (previous && previous->subscribeTopic != latest->subscribeTopic) {
+            DropBufferRoute(previous->subscribeTopic);
+        }
+        ApplyConfig(latest);
+        subscribedTopics.clear();
+        Serial.println("[AwsIotCoreOperations] Applied updated config");
     }
 
     Private Bool EnsureConfigured() {
@@ -113,35 +200,15 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
             return false;
         }
 
-        endpoint = configProvider->GetEndpoint();
-        thingName = configProvider->GetThingName();
-        caCert = configProvider->GetCaCert();
-        deviceCert = configProvider->GetDeviceCert();
-        privateKey = configProvider->GetPrivateKey();
-        publishTopic = configProvider->GetPublishTopic();
-        subscribeTopic = configProvider->GetSubscribeTopic();
-
-        secureClient.setCACert(caCert.c_str());
-        secureClient.setCertificate(deviceCert.c_str());
-        secureClient.setPrivateKey(privateKey.c_str());
-
-        mqttClient.setServer(endpoint.c_str(), 8883);
-        mqttClient.setCallback(StaticMqttCallback);
+        configProvider->Refresh();
+        ApplyConfig(configProvider->GetConfig());
+        mqttClient.setCallback([this](Char* topic, UInt8* payload, UInt length) { OnMqttMessage(topic, payload, length); });
         // Publish payloads can exceed 1 KB (e.g. batched logs), so keep MQTT packet buffer larger.
         mqttClient.setBufferSize(4096);
         PrintRuntimeStats("EnsureConfigured configured");
         PrintMqttState("EnsureConfigured state");
 
-        activeInstance = this;
         configured = true;
-        //Serial.print("[AwsIotCoreOperations] Configured endpoint=");
-        //Serial.print(endpoint.c_str());
-        //Serial.print(" thingName=");
-        //Serial.print(thingName.c_str());
-        //Serial.print(" publishTopic=");
-        //Serial.print(publishTopic.c_str());
-        //Serial.print(" subscribeTopic=");
-        //Serial.println(subscribeTopic.c_str());
         return true;
     }
 
@@ -175,44 +242,63 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
         }
         //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected mqtt not connected");
         PrintRuntimeStats("EnsureMqttConnected before mqttClient.connect");
-        //Serial.print("[AwsIotCoreOperations] EnsureMqttConnected endpoint=");
-        //Serial.print(endpoint.c_str());
-        //Serial.print(" port=8883 thingNameLen=");
-        //Serial.println(static_cast<UInt>(thingName.length()));
         //Serial.print("[AwsIotCoreOperations] EnsureMqttConnected DNS0=");
         //Serial.print(WiFi.dnsIP(0));
         //Serial.print(" DNS1=");
         //Serial.println(WiFi.dnsIP(1));
-        IPAddress resolvedIp;
-        if (!WiFi.hostByName(endpoint.c_str(), resolvedIp)) {
-            Serial.println("[AwsIotCoreOperations] EnsureMqttConnected DNS precheck failed");
-            PrintMqttState("EnsureMqttConnected DNS precheck fail state");
+        if (!HasEnoughTlsHeadroom("EnsureMqttConnected connect")) {
             wasConnected = false;
             return false;
         }
-        //Serial.print("[AwsIotCoreOperations] EnsureMqttConnected endpoint resolved to=");
-        //Serial.println(resolvedIp);
-        //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected calling mqttClient.connect NOW");
-        if (!HasEnoughTlsHeadroom("EnsureMqttConnected connect")) {
+        ULong attemptStartMs = millis();
+        if (!connectBreaker.TryAcquire(attemptStartMs)) {
+            wasConnected = false;
+            return false;
+        }
+        ReloadConfigIfChanged();
+        uint32_t address = 0;
+        if (dnsCache == nullptr || !dnsCache->Lookup(config->endpoint, address)) {
+            Serial.println("[AwsIotCoreOperations] EnsureMqttConnected DNS lookup failed");
+            PrintMqttState("EnsureMqttConnected DNS lookup fail state");
+            connectBreaker.RecordFailure(millis(), millis() - attemptStartMs);
             wasConnected = false;
             return false;
         }
-        Bool connected = mqttClient.connect(thingName.c_str());
+        // Open TLS to the cached address ourselves, with the endpoint as SNI and verification name;
+        // mqttClient.connect() then reuses the open socket instead of resolving the endpoint again.
+        ackClient.stop();
+        if (!secureClient.connect(IPAddress(address), 8883, config->endpoint, config->caCert, config->deviceCert,
+                                  config->privateKey)) {
+            Serial.println("[AwsIotCoreOperations] EnsureMqttConnected TLS connect failed");
+            dnsCache->Invalidate(config->endpoint);
+            connectBreaker.RecordFailure(millis(), millis() - attemptStartMs);
+            wasConnected = false;
+            return false;
+        }
+        //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected calling mqttClient.connect NOW");
+        Bool connected = mqttClient.connect(config->thingName);
+        if (connected) {
+            connectBreaker.RecordSuccess(millis() - attemptStartMs);
+        } else {
+            connectBreaker.RecordFailure(millis(), millis() - attemptStartMs);
+        }
         //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected mqtt connect result=");
         PrintRuntimeStats("EnsureMqttConnected after mqttClient.connect");
         PrintMqttState("EnsureMqttConnected post connect");
         if (connected) {
             //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected mqtt connect success");
-            // MQTT session is new; previous subscriptions are no longer guaranteed.
-            if (wasConnected == false) {
-                //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected subscribed topics cleared");
-                subscribedTopics.clear();
-            }
+            // MQTT session is new (clean session), so the broker kept none of the previous subscriptions,
+            // even when the old connection dropped without wasConnected ever being cleared.
+            subscribedTopics.clear();
+            // Unacknowledged QoS 1 publishes did not survive the old session; resend them with DUP set.
+            resendInflight = inflight.Count() > 0;
             wasConnected = true;
             //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected subscribed topics cleared");
 
             // Immediately subscribe to default topic on successful connect.
+            const StdString& subscribeTopic = config->subscribeTopic;
             if (!subscribeTopic.empty()) {
+                EnsureBufferRoute(subscribeTopic);
                 //Serial.println("[AwsIotCoreOperations] EnsureMqttConnected subscribing to topic=");
                 //Serial.println(subscribeTopic.c_str());
                 PrintRuntimeStats("EnsureMqttConnected before default subscribe");
@@ -229,6 +315,7 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
                     //Serial.println(subscribeTopic.c_str());
                 }
             }
+            SubscribeRoutedFilters();
         } else {
             Serial.println("[AwsIotCoreOperations] EnsureMqttConnected mqtt connect failed");
             secureClient.stop();
@@ -254,6 +341,7 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
             Serial.println("[AwsIotCoreOperations] EnsureSubscribed lock timeout");
             return false;
         }
+        EnsureBufferRoute(topicName);
         if (subscribedTopics.find(topicName) != subscribedTopics.end()) {
             return true;
         }
@@ -268,8 +356,60 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
         return false;
     }
 
-    Public AwsIotCoreOperations() : mqttClient(secureClient) {
+    Private uint16_t AllocatePacketId() {
+        for (;;) {
+            if (nextPacketId == 0) nextPacketId = 1;
+            uint16_t packetId = nextPacketId++;
+            if (!inflight.Contains(packetId)) return packetId;
+        }
+    }
+
+    /** Encodes a QoS 1 PUBLISH packet (MQTT 3.1.1) with the given packet id. */
+    Private Static StdString EncodeQos1Publish(CStdString topicName, CStdString message, uint16_t packetId) {
+        Size remaining = 2 + topicName.size() + 2 + message.size();
+        StdString packet;
+        packet.reserve(remaining + 5);
+        packet += static_cast<Char>(0x32);
+        do {
+            UInt8 b = static_cast<UInt8>(remaining % 128);
+            remaining /= 128;
+            if (remaining > 0) b |= 0x80;
+            packet += static_cast<Char>(b);
+        } while (remaining > 0);
+        packet += static_cast<Char>((topicName.size() >> 8) & 0xFF);
+        packet += static_cast<Char>(topicName.size() & 0xFF);
+        packet += topicName;
+        packet += static_cast<Char>((packetId >> 8) & 0xFF);
+        packet += static_cast<Char>(packetId & 0xFF);
+        packet += message;
+        return packet;
+    }
+
+    /** Call with mqttMutex held. */
+    Private Bool WritePacket(CStdString packet) {
+        if (!mqttClient.connected()) {
+            return false;
+        }
+        size_t n = ackClient.write(reinterpret_cast<const uint8_t*>(packet.data()), packet.size());
+        return n == packet.size();
+    }
+
+    /** Retransmits timed-out QoS 1 publishes and settles exhausted ones. Call with mqttMutex held, after loop(). */
+    Private Void ServiceInflight() {
+        if (inflight.Count() == 0) {
+            resendInflight = false;
+            return;
+        }
+        Bool force = resendInflight;
+        resendInflight = false;
+        inflight.ServiceRetries(millis(), kPubackTimeoutMs, kMaxPublishAttempts, force,
+            [this](CStdString packet) { return WritePacket(packet); });
+    }
+
+    Public AwsIotCoreOperations() : ackClient(secureClient), mqttClient(ackClient) {
         mqttMutex = xSemaphoreCreateMutex();
+        // Invoked from mqttClient.loop(), which always runs with mqttMutex held.
+        ackClient.SetPubackHandler([this](uint16_t packetId) { inflight.Acknowledge(packetId); });
     }
 
     Public Virtual ~AwsIotCoreOperations() override {
@@ -284,14 +424,16 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
             Serial.println("[AwsIotCoreOperations] SendMessage failed: not configured");
             return false;
         }
-        return SendMessage(message, publishTopic);
+        AwsIotCoreConfigPtr current = CurrentConfig();
+        return SendMessage(message, current->publishTopic);
     }
 
     Public Virtual StdVector<StdString> ReceiveMessages() override {
         if (!EnsureConfigured()) {
             return StdVector<StdString>();
         }
-        return ReceiveMessages(subscribeTopic);
+        AwsIotCoreConfigPtr current = CurrentConfig();
+        return ReceiveMessages(current->subscribeTopic);
     }
 
     Public Virtual Bool SendMessage(CStdString message, CStdString topicName) override {
@@ -313,8 +455,11 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
         }
         PrintRuntimeStats("SendMessage before mqttClient.loop");
         mqttClient.loop();
+        ServiceInflight();
         PrintRuntimeStats("SendMessage before publish");
-        Bool ok = mqttClient.publish(topicName.c_str(), message.c_str());
+        // Length-delimited so binary (MessagePack) payloads are not cut at the first zero byte.
+        Bool ok = mqttClient.publish(topicName.c_str(), reinterpret_cast<const uint8_t*>(message.data()),
+                                     static_cast<UInt>(message.size()));
         if (!ok) {
             Serial.println("[AwsIotCoreOperations] mqttClient.publish FAILED");
         }
@@ -337,6 +482,7 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
             return result;
         }
         mqttClient.loop();
+        ServiceInflight();
 
         auto it = bufferedMessages.find(topicName);
         if (it == bufferedMessages.end()) {
@@ -344,14 +490,118 @@ class AwsIotCoreOperations : public IAwsIotCoreOperations {
             return result;
         }
 
-        result = it->second;
-        bufferedMessages.erase(it);
+        result.swap(it->second);
         //Serial.print("[AwsIotCoreOperations] Receive poll: returning messages count = ");
         //Serial.println(static_cast<Int>(result.size()));
         return result;
     }
-};
 
-AwsIotCoreOperations* AwsIotCoreOperations::activeInstance = nullptr;
+    Public Virtual ULong GetDroppedMessageCount() const override {
+        return droppedBufferedMessages.load();
+    }
+
+    Public Virtual uint16_t SendMessageAtLeastOnce(CStdString message) override {
+        if (!EnsureConfigured()) {
+            Serial.println("[AwsIotCoreOperations] SendMessageAtLeastOnce failed: not configured");
+            return 0;
+        }
+        AwsIotCoreConfigPtr current = CurrentConfig();
+        return SendMessageAtLeastOnce(message, current->publishTopic);
+    }
+
+    Public Virtual uint16_t SendMessageAtLeastOnce(CStdString message, CStdString topicName) override {
+        if (!EnsureMqttConnected()) {
+            Serial.println("[AwsIotCoreOperations] SendMessageAtLeastOnce failed: MQTT not connected");
+            return 0;
+        }
+        if (!HasEnoughTlsHeadroom("SendMessageAtLeastOnce publish")) {
+            return 0;
+        }
+        MqttLockGuard lock(mqttMutex);
+        if (!lock.IsLocked()) {
+            Serial.println("[AwsIotCoreOperations] SendMessageAtLeastOnce lock timeout");
+            return 0;
+        }
+        mqttClient.loop();
+        ServiceInflight();
+        if (inflight.IsFull()) {
+            return 0;
+        }
+        uint16_t packetId = AllocatePacketId();
+        StdString packet = EncodeQos1Publish(topicName, message, packetId);
+        if (!WritePacket(packet)) {
+            Serial.println("[AwsIotCoreOperations] SendMessageAtLeastOnce write FAILED");
+            return 0;
+        }
+        inflight.Add(packetId, std::move(packet), millis());
+        return packetId;
+    }
+
+    Public Virtual UInt Subscribe(CStdString topicFilter, MqttMessageHandler handler) override {
+        MqttLockGuard lock(mqttMutex);
+        if (!lock.IsLocked()) {
+            Serial.println("[AwsIotCoreOperations] Subscribe lock timeout");
+            return 0;
+        }
+        UInt id = router.Subscribe(topicFilter, std::move(handler));
+        if (id != 0 && mqttClient.connected() && subscribedTopics.find(topicFilter) == subscribedTopics.end()
+            && mqttClient.subscribe(topicFilter.c_str())) {
+            subscribedTopics.insert(topicFilter);
+        }
+        // Otherwise SubscribeRoutedFilters() picks it up on the next connect.
+        return id;
+    }
+
+    Public Virtual Bool Unsubscribe(UInt subscriptionId) override {
+        MqttLockGuard lock(mqttMutex);
+        if (!lock.IsLocked()) {
+            Serial.println("[AwsIotCoreOperations] Unsubscribe lock timeout");
+            return false;
+        }
+        StdString filter;
+        if (!router.Unsubscribe(subscriptionId, &filter)) {
+            return false;
+        }
+        if (!router.HasFilter(filter) && subscribedTopics.erase(filter) > 0 && mqttClient.connected()) {
+            mqttClient.unsubscribe(filter.c_str());
+        }
+        return true;
+    }
+
+    Public Virtual Bool Connect() override {
+        if (!EnsureConfigured()) {
+            return false;
+        }
+        AwsIotCoreConfigPtr current = CurrentConfig();
+        if (current->subscribeTopic.empty()) {
+            return EnsureMqttConnected();
+        }
+        return EnsureSubscribed(current->subscribeTopic);
+    }
+
+    Public Virtual Bool IsConnected() const override {
+        return wasConnected.load();
+    }
+
+    Public Virtual Bool IsCircuitOpen() const override {
+        return connectBreaker.IsOpen(millis());
+    }
+
+    Public Virtual Void ResetCircuit() override {
+        connectBreaker.Reset();
+    }
+
+    Public Virtual CircuitBreakerStats GetCircuitStats() const override {
+        return connectBreaker.GetStats();
+    }
+
+    Public Virtual StdVector<MqttPublishCompletion> TakePublishCompletions() override {
+        MqttLockGuard lock(mqttMutex);
+        if (!lock.IsLocked()) {
+            return StdVector<MqttPublishCompletion>();
+        }
+        return inflight.TakeCompletions();
+    }
+};
 
 #endif /* AWSIOTCOREOPERATIONS_H */
@@ -0,0 +1,19 @@
+#ifndef CLOUDCOMMAND_H
+#define CLOUDCOMMAND_H
+
+#include <StandardDefines.h>
+
+/** A command decoded once from a cloud payload and handed through the facade as-is. */
+struct CloudCommand {
+    /** Command key (e.g. the RTDB/MQTT message key); empty for raw text payloads without one. */
+    StdString key;
+    /** Command body, e.g. the raw HTTP request handed to the server. */
+    StdString value;
+    /** True for "done" markers, which carry no command. */
+    Bool done = false;
+    /** True if key came from an explicit "key" field (JSON or MessagePack), not from splitting raw text at ':'.
+     *  Only explicit keys identify a command, so only they are used to drop redeliveries. */
+    Bool keyExplicit = false;
+};
+
+#endif /* CLOUDCOMMAND_H */
@@ -0,0 +1,108 @@
+#ifndef CLOUDCOMMANDDECODER_H
+#define CLOUDCOMMANDDECODER_H
+
+#include "CloudCommand.h"
+#include "CloudWireFormat.h"
+#include "MsgPackReader.h"
+#include "LzssDecoder.h"
+
+#include <ArduinoJson.h>
+
+/**
+ * Decodes one inbound command payload into a CloudCommand in a single pass: envelope detection, optional
+ * decompression, then exactly one JSON or MessagePack parse. Accepted shapes:
+ *  - {"key": str, "value": str} / MessagePack map with the same fields, optionally with "done": true;
+ *  - "done" or {"done": true} markers;
+ *  - any other text, taken as "key:value" split at the first ':' (whole text as value if there is none).
+ */
+class CloudCommandDecoder {
+    /** Largest decompressed body accepted; the same as the MQTT receive buffer. */
+    Private Static constexpr Size kMaxDecompressedSize = 4096;
+
+    Private Static Void DecodeRaw(const Char* data, Size len, CloudCommand& out) {
+        StdString text(data, len);
+        if (text == "done") {
+            out.done = true;
+            return;
+        }
+        Size colon = text.find(':');
+        if (colon != StdString::npos && colon + 1 < text.size()) {
+            out.key = text.substr(0, colon);
+            out.value = text.substr(colon + 1);
+        } else {
+            out.value = std::move(text);
+        }
+    }
+
+    Private Static Bool DecodeJson(const Char* data, Size len, CloudCommand& out) {
+        JsonDocument doc;
+        if (deserializeJson(doc, data, len)) {
+            DecodeRaw(data, len, out);
+            return true;
+        }
+        if (doc["done"].is<bool>() && doc["done"].as<bool>()) {
+            out.done = true;
+            return true;
+        }
+        const char* k = doc["key"].as<const char*>();
+        const char* v = doc["value"].as<const char*>();
+        if (k && v) {
+            out.key = k;
+            out.value = v;
+            out.keyExplicit = true;
+            return true;
+        }
+        DecodeRaw(data, len, out);
+        return true;
+    }
+
+    Private Static Bool DecodeMsgPack(const Char* data, Size len, CloudCommand& out) {
+        MsgPackReader reader(reinterpret_cast<const UInt8*>(data), len);
+        uint32_t count = 0;
+        if (!reader.ReadMapHeader(count)) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            const Char* name = nullptr;
+            Size nameLen = 0;
+            if (!reader.ReadString(name, nameLen)) return false;
+            StdString field(name, nameLen);
+            const Char* str = nullptr;
+            Size strLen = 0;
+            if (field == "done" && reader.PeekType() == MsgPackType::Bool) {
+                if (!reader.ReadBool(out.done)) return false;
+            } else if ((field == "key" || field == "value") && reader.PeekType() == MsgPackType::String) {
+                if (!reader.ReadString(str, strLen)) return false;
+                (field == "key" ? out.key : out.value).assign(str, strLen);
+            } else if (!reader.Skip()) {
+                return false;
+            }
+        }
+        out.keyExplicit = !out.key.empty();
+        return out.done || (!out.key.empty() && !out.value.empty());
+    }
+
+    Private Static Bool DecodeBody(CloudWireFormat format, const Char* data, Size len, CloudCommand& out) {
+        if (format == CloudWireFormat::MessagePack) {
+            return DecodeMsgPack(data, len, out);
+        }
+        return DecodeJson(data, len, out);
+    }
+
+    /** Returns false for corrupt or malformed payloads; @p out is reset first. */
+    Public Static Bool Decode(CStdString payload, CloudCommand& out) {
+        out = CloudCommand();
+        if (payload.empty()) return false;
+        CloudWireFormat format;
+        Bool compressed = false;
+        Size offset = CloudPayloadEnvelope::Detect(payload, format, compressed);
+        if (!compressed) {
+            return DecodeBody(format, payload.data() + offset, payload.size() - offset, out);
+        }
+        StdString body;
+        if (!LzssDecoder<>::Decode(reinterpret_cast<const UInt8*>(payload.data()) + offset, payload.size() - offset, body, kMaxDecompressedSize)) {
+            return false;
+        }
+        return DecodeBody(format, body.data(), body.size(), out);
+    }
+};
+
+#endif /* CLOUDCOMMANDDECODER_H */
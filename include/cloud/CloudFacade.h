@@ -8,16 +8,25 @@
 #include <ILogger.h>
 #include <IInternetConnectionStatusProvider.h>
 #include <Arduino.h>
+#include "../common/BoundedMpscQueue.h"
+#include "../common/AdaptivePollScheduler.h"
+#include "../common/AsyncRelease.h"
 
-#include <queue>
+#include <atomic>
 #include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 /* @Component */
 /* @Scope("PROTOTYPE") */
 class CloudFacade : public ICloudFacade {
 
+    /** Published with std::atomic_store and read with std::atomic_load, so the hot paths never take cloudOperationsMutex_. */
     Private ICloudOperationsPtr cloudOperations_;
+    /** Serialises Reset/Stop/Start (the writers) and guards parkedOperations_. */
     Private mutable std::mutex cloudOperationsMutex_;
+    /** Instance set aside by StopCloudOperations so StartCloudOperations resumes it warm; guarded by cloudOperationsMutex_. */
+    Private ICloudOperationsPtr parkedOperations_;
 
     /* @Autowired */
     Private ILoggerPtr logger;
@@ -25,21 +34,136 @@ class CloudFacade : public ICloudFacade {
     /* @Autowired */
     Private IInternetConnectionStatusProviderPtr internetConnectionStatusProvider_;
 
-    Private std::queue<StdString> requestQueue_;
-    Private std::mutex requestQueueMutex_;
+    Private Static constexpr Size kCommandQueueCapacity = 32;
+    /** Pending commands. Polls fetch no more than the free space, so an accepted command is never dropped. */
+    Private BoundedMpscQueue<CloudCommand, kCommandQueueCapacity> requestQueue_{QueueOverflowPolicy::RejectNewest};
+    /** Keeps polls (caller and prefetch task) one at a time, so the free space measured before a poll is still free when it is enqueued. */
+    Private std::atomic<bool> pollInProgress_{false};
 
-    Private Bool TryDequeue(StdString& out) {
-        std::lock_guard<std::mutex> lock(requestQueueMutex_);
-        if (requestQueue_.empty()) return false;
-        out = requestQueue_.front();
-        requestQueue_.pop();
+    Private Bool TryDequeue(CloudCommand& out) {
+        return requestQueue_.TryDequeue(out);
+    }
+
+    /** Free queue slots; only the poller adds items, so the value can only grow until it enqueues. */
+    Private Size QueueRoom() const {
+        Size size = requestQueue_.SizeApprox();
+        return size >= kCommandQueueCapacity ? 0 : kCommandQueueCapacity - size;
+    }
+
+    Private Void EnqueueAll(StdVector<CloudCommand>& commands) {
+        for (CloudCommand& c : commands) {
+            if (!requestQueue_.TryEnqueue(std::move(c)) && logger) {
+                logger->Error(Tag::Untagged, StdString("[CloudFacade] Command queue full, command not queued"));
+            }
+        }
+    }
+
+    /** MQTT + TLS reads need more than the default pthread stack. */
+    Private Static constexpr uint32_t kPrefetchTaskStackSize = 8192;
+    Private std::atomic<bool> prefetchInFlight_{false};
+
+#ifdef CLOUD_PREWARM_ON_START
+    Private std::atomic<bool> prewarmOnStart_{true};
+#else
+    Private std::atomic<bool> prewarmOnStart_{false};
+#endif
+    Private std::atomic<bool> prewarmInFlight_{false};
+    Private std::atomic<bool> prewarmFailed_{false};
+    Private std::atomic<ULong> startedAtMs_{0};
+    Private std::atomic<ULong> connectLatencyMs_{0};
+    Private std::atomic<ULong> firstCommandLatencyMs_{0};
+
+    /** Records start-to-first-command once per start. */
+    Private Void NoteCommandHandedOut() {
+        if (firstCommandLatencyMs_.load(std::memory_order_relaxed) != 0) return;
+        ULong elapsed = millis() - startedAtMs_.load();
+        ULong expected = 0;
+        firstCommandLatencyMs_.compare_exchange_strong(expected, elapsed == 0 ? 1 : elapsed);
+    }
+    Private AdaptivePollScheduler pollScheduler_;
+
+    Private Size DrainQueue(Size max, StdVector<CloudCommand>& out) {
+        Size taken = 0;
+        CloudCommand cmd;
+        while (taken < max && TryDequeue(cmd)) {
+            out.push_back(std::move(cmd));
+            ++taken;
+        }
+        return taken;
+    }
+
+    /** One cloud round trip; retrieved commands go to the queue. Returns false if the poll was skipped (including by the poll scheduler). */
+    Private Bool PollCommands() {
+        if (!pollScheduler_.ShouldPoll(millis())) {
+            return false;
+        }
+        if (internetConnectionStatusProvider_ && !internetConnectionStatusProvider_->IsInternetConnected()) {
+            //Serial.println("[CloudFacade] GetCommand skip: network not connected");
+            //if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: network not connected"));
+            return false;
+        }
+        ICloudOperationsPtr ops = CurrentOperations();
+        if (!ops) {
+            //Serial.println("[CloudFacade] GetCommand skip: no cloud operations");
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: no cloud operations"));
+            return false;
+        }
+        if (ops->IsDirty()) {
+            //Serial.println("[CloudFacade] GetCommand skip: operations dirty");
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: operations dirty"));
+            return false;
+        }
+        if (ops->IsOperationInProgress()) {
+            //Serial.println("[CloudFacade] GetCommand skip: operation already in progress");
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: operation already in progress"));
+            return false;
+        }
+        if (pollInProgress_.exchange(true)) {
+            return false;
+        }
+        struct ClearPoll { std::atomic<bool>& f; ~ClearPoll() { f.store(false); } } pollGuard{pollInProgress_};
+        Size room = QueueRoom();
+        if (room == 0) {
+            return false;
+        }
+        StdVector<CloudCommand> commands = ops->RetrieveCommands(room);
+        //Serial.print("[CloudFacade] RetrieveCommands count=");
+        //Serial.println(static_cast<Int>(commands.size()));
+        pollScheduler_.OnPoll(millis(), !commands.empty());
+        EnqueueAll(commands);
         return true;
     }
 
-    Private Void EnqueueAll(const StdVector<StdString>& commands) {
-        std::lock_guard<std::mutex> lock(requestQueueMutex_);
-        for (const StdString& s : commands) {
-            requestQueue_.push(s);
+    Private Static Void PrefetchTask(Void* arg) {
+        CloudFacade* self = static_cast<CloudFacade*>(arg);
+        self->PollCommands();
+        self->prefetchInFlight_.store(false);
+        vTaskDelete(nullptr);
+    }
+
+    Private Static Void PrewarmTask(Void* arg) {
+        CloudFacade* self = static_cast<CloudFacade*>(arg);
+        ICloudOperationsPtr ops = self->CurrentOperations();
+        Bool ok = ops && ops->Prewarm();
+        if (ok) {
+            ULong elapsed = millis() - self->startedAtMs_.load();
+            self->connectLatencyMs_.store(elapsed == 0 ? 1 : elapsed);
+        }
+        self->prewarmFailed_.store(!ok);
+        self->prewarmInFlight_.store(false);
+        vTaskDelete(nullptr);
+    }
+
+    /** Starts PrewarmTask unless one is already running. */
+    Private Void StartPrewarm() {
+        if (prewarmInFlight_.exchange(true)) {
+            return;
+        }
+        prewarmFailed_.store(false);
+        if (xTaskCreate(PrewarmTask, "cloudPrewarm", kPrefetchTaskStackSize, this, 1, nullptr) != pdPASS) {
+            prewarmInFlight_.store(false);
+            prewarmFailed_.store(true);
+            if (logger) logger->Error(Tag::Untagged, StdString("[CloudFacade] Prewarm: failed to start task"));
         }
     }
 
@@ -47,37 +171,99 @@ class CloudFacade : public ICloudFacade {
         ResetCloudOperations();
     }
 
-    Public Virtual ~CloudFacade() override = default;
+    Public Virtual ~CloudFacade() override {
+        // The prefetch and prewarm tasks use this instance; let them finish first.
+        while (prefetchInFlight_.load() || prewarmInFlight_.load()) {
+            delay(10);
+        }
+        ReleaseAsync(std::move(cloudOperations_), "cloudRelease");
+        ReleaseAsync(std::move(parkedOperations_), "cloudRelease");
+    }
+
+    Private ICloudOperationsPtr CurrentOperations() const {
+        return std::atomic_load(&cloudOperations_);
+    }
+
+    /** Call with cloudOperationsMutex_ held. Makes the parked instance (or a new one) current if there is none. */
+    Private Void EnsureOperations() {
+        if (cloudOperations_) return;
+        if (parkedOperations_) {
+            std::atomic_store(&cloudOperations_, std::move(parkedOperations_));
+            parkedOperations_ = nullptr;
+        } else {
+            std::atomic_store(&cloudOperations_, ICloudOperationsPtr(std::make_shared<CloudOperations>()));
+        }
+    }
 
-    /** Thread-safe: replaces cloudOperations_ with a new CloudOperations instance and clears command queue. */
+    /** Thread-safe soft reset: clears error state and the command queue but keeps the instance, its MQTT session,
+     *  subscriptions, in-flight batches and dedup state. */
     Public Void ResetCloudOperations() override {
         //Serial.println("[CloudFacade] ResetCloudOperations()");
         if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] Resetting cloud operations."));
         std::lock_guard<std::mutex> lock(cloudOperationsMutex_);
-        cloudOperations_ = std::make_shared<CloudOperations>();
-        {
-            std::lock_guard<std::mutex> q(requestQueueMutex_);
-            while (!requestQueue_.empty()) requestQueue_.pop();
-        }
+        EnsureOperations();
+        cloudOperations_->SoftReset();
+        requestQueue_.Clear();
+        pollScheduler_.Reset();
     }
 
+    /** Parks the instance; nothing is torn down, so a later Start resumes immediately. */
     Public Void StopCloudOperations() override {
         //Serial.println("[CloudFacade] StopCloudOperations()");
         if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] Stopping cloud operations."));
         std::lock_guard<std::mutex> lock(cloudOperationsMutex_);
-        cloudOperations_ = nullptr;
+        if (cloudOperations_) {
+            parkedOperations_ = std::atomic_exchange(&cloudOperations_, ICloudOperationsPtr());
+        }
     }
 
     Public Void StartCloudOperations() override {
         //Serial.println("[CloudFacade] StartCloudOperations()");
         if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] Starting cloud operations."));
         std::lock_guard<std::mutex> lock(cloudOperationsMutex_);
-        cloudOperations_ = std::make_shared<CloudOperations>();
+        EnsureOperations();
+        startedAtMs_.store(millis());
+        connectLatencyMs_.store(0);
+        firstCommandLatencyMs_.store(0);
+        if (prewarmOnStart_.load()) {
+            StartPrewarm();
+        }
+    }
+
+    Public Void SetPrewarmOnStart(Bool enabled) override {
+        prewarmOnStart_.store(enabled);
+    }
+
+    Public CloudReadiness GetReadiness() const override {
+        ICloudOperationsPtr ops = CurrentOperations();
+        CloudReadinessState state;
+        if (!ops) state = CloudReadinessState::Stopped;
+        else if (ops->IsConnected()) state = CloudReadinessState::Ready;
+        else if (prewarmInFlight_.load()) state = CloudReadinessState::Warming;
+        else if (prewarmFailed_.load()) state = CloudReadinessState::Failed;
+        else state = CloudReadinessState::Cold;
+        return CloudReadiness{state, startedAtMs_.load(), connectLatencyMs_.load(), firstCommandLatencyMs_.load()};
+    }
+
+    Public Void SetPollInterval(ULong floorMs, ULong ceilingMs) override {
+        pollScheduler_.Configure(floorMs, ceilingMs);
+    }
+
+    Public QueueStats GetCommandQueueStats() const override {
+        QueueStats stats = requestQueue_.GetStats();
+        ICloudOperationsPtr ops = CurrentOperations();
+        if (ops) stats.dropped += ops->GetDroppedCommandCount();
+        return stats;
+    }
+
+    Public CircuitBreakerStats GetCircuitStats() const override {
+        ICloudOperationsPtr ops = CurrentOperations();
+        return ops ? ops->GetCircuitStats() : CircuitBreakerStats{CircuitState::Closed, 0, 0, 0, 0, 0, 0, 0, 0};
     }
 
     Public Bool IsDirty() const override {
-        std::lock_guard<std::mutex> lock(cloudOperationsMutex_);
-        return cloudOperations_ ? cloudOperations_->IsDirty() : false;
+        ICloudOperationsPtr ops = CurrentOperations();
+        return ops ? ops->IsDirty() : false;
     }
 
     Public Bool PublishLogs(const StdMap<ULongLong, StdString>& logs) override {
@@ -88,11 +274,7 @@ class CloudFacade : public ICloudFacade {
             //if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] PublishLogs skip: network not connected"));
             return false;
         } */
-        ICloudOperationsPtr ops;
-        {
-            std::lock_guard<std::mutex> lock(cloudOperationsMutex_);
-            ops = cloudOperations_;
-        }
+        ICloudOperationsPtr ops = CurrentOperations();
         if (!ops) {
             //Serial.println("[CloudFacade] PublishLogs skip: no cloud operations");
             if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] PublishLogs skip: no cloud operations"));
@@ -117,53 +299,65 @@ class CloudFacade : public ICloudFacade {
         return ok;
     }
 
-    Public StdString GetCommand() override {
-        //Serial.println("[CloudFacade] GetCommand() called");
-        StdString out;
-        if (TryDequeue(out)) {
-            //Serial.print("[CloudFacade] GetCommand() from queue -> ");
-            //Serial.println(out.c_str());
-            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand: from queue: ") + out);
-            return out;
-        }
-        if (internetConnectionStatusProvider_ && !internetConnectionStatusProvider_->IsInternetConnected()) {
-            //Serial.println("[CloudFacade] GetCommand skip: network not connected");
-            //if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: network not connected"));
-            return StdString();
-        }
-        ICloudOperationsPtr ops;
-        {
-            std::lock_guard<std::mutex> lock(cloudOperationsMutex_);
-            ops = cloudOperations_;
-        }
+    Public Bool PublishLogs(const StdMap<ULongLong, StdString>& logs, StdVector<CloudPublishCompletion>& completed) override {
+        completed.clear();
+        ICloudOperationsPtr ops = CurrentOperations();
         if (!ops) {
-            //Serial.println("[CloudFacade] GetCommand skip: no cloud operations");
-            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: no cloud operations"));
-            return StdString();
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] PublishLogs skip: no cloud operations"));
+            return false;
         }
         if (ops->IsDirty()) {
-            //Serial.println("[CloudFacade] GetCommand skip: operations dirty");
-            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: operations dirty"));
-            return StdString();
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] PublishLogs skip: operations dirty"));
+            return false;
         }
         if (ops->IsOperationInProgress()) {
-            //Serial.println("[CloudFacade] GetCommand skip: operation already in progress");
-            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand skip: operation already in progress"));
-            return StdString();
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] PublishLogs skip: operation already in progress"));
+            return false;
         }
-        StdVector<StdString> commands = ops->RetrieveCommands();
-        //Serial.print("[CloudFacade] RetrieveCommands count=");
-        //Serial.println(static_cast<Int>(commands.size()));
-        //if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand: RetrieveCommands returned ") + std::to_string(commands.size()) + " command(s)");
-        EnqueueAll(commands);
+        return ops->PublishLogs(logs, completed);
+    }
+
+    Public Bool GetCommand(CloudCommand& out) override {
+        //Serial.println("[CloudFacade] GetCommand() called");
+        if (TryDequeue(out)) {
+            //Serial.print("[CloudFacade] GetCommand() from queue -> ");
+            //Serial.println(out.key.c_str());
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand: from queue: ") + out.key);
+            NoteCommandHandedOut();
+            return true;
+        }
+        PollCommands();
         if (TryDequeue(out)) {
             //Serial.print("[CloudFacade] GetCommand returning -> ");
             //Serial.println(out.c_str());
-            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand: returning ") + out);
-            return out;
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudFacade] GetCommand: returning ") + out.key);
+            NoteCommandHandedOut();
+            return true;
         }
         //Serial.println("[CloudFacade] GetCommand returning empty");
-        return StdString();
+        return false;
+    }
+
+    Public Size GetCommands(Size max, StdVector<CloudCommand>& out) override {
+        Size taken = DrainQueue(max, out);
+        if (taken == 0 && max > 0) {
+            PollCommands();
+            taken = DrainQueue(max, out);
+        }
+        if (taken > 0) {
+            NoteCommandHandedOut();
+        }
+        return taken;
+    }
+
+    Public Void PrefetchCommands() override {
+        if (prefetchInFlight_.exchange(true)) {
+            return;
+        }
+        if (xTaskCreate(PrefetchTask, "cloudPrefetch", kPrefetchTaskStackSize, this, 1, nullptr) != pdPASS) {
+            prefetchInFlight_.store(false);
+            if (logger) logger->Error(Tag::Untagged, StdString("[CloudFacade] PrefetchCommands: failed to start task"));
+        }
     }
 };
 
@@ -3,20 +3,29 @@
 
 #include "ICloudOperations.h"
 #include "IAwsIotCoreOperations.h"
+#include "IAwsIotCoreConfigProvider.h"
+#include "CloudWireFormat.h"
+#include "MsgPackWriter.h"
+#include "LzssEncoder.h"
+#include "CloudCommandDecoder.h"
+#include "../common/CommandKeyDeduplicator.h"
+#include "../common/TimestampFormatter.h"
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <ILogger.h>
 #include <atomic>
+#include <deque>
+#include <memory>
 
 class CloudOperations : public ICloudOperations {
     Public CloudOperations() = default;
 
-    Public StdVector<StdString> RetrieveCommands() override {
+    Public StdVector<CloudCommand> RetrieveCommands(Size max) override {
         //Serial.println("[CloudOperations] RetrieveCommands() begin");
-        if (dirty_.load(std::memory_order_relaxed)) {
+        if (IsDirty()) {
             //Serial.println("[CloudOperations] RetrieveCommands skip: dirty");
-            if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] RetrieveCommands skip: dirty"));
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] RetrieveCommands skip: circuit open"));
             return {};
         }
         if (operationInProgress_.exchange(true)) {
@@ -34,22 +43,37 @@ class CloudOperations : public ICloudOperations {
         StdVector<StdString> incoming = awsIotCoreOperations_->ReceiveMessages();
         //Serial.print("[CloudOperations] Raw incoming count=");
         //Serial.println(static_cast<Int>(incoming.size()));
-        StdVector<StdString> out;
-        out.reserve(incoming.size());
-        for (const auto& msg : incoming) {
+        for (StdString& msg : incoming) {
+            if (undelivered_.size() >= kMaxUndelivered) {
+                undelivered_.pop_front();
+                ++droppedUndelivered_;
+            }
+            undelivered_.push_back(std::move(msg));
+        }
+        StdVector<CloudCommand> out;
+        while (out.size() < max && !undelivered_.empty()) {
+            StdString msg(std::move(undelivered_.front()));
+            undelivered_.pop_front();
             //Serial.print("[CloudOperations] Raw incoming payload: ");
             //Serial.println(msg.c_str());
-            if (IsDonePayload(msg)) {
+            CloudCommand cmd;
+            if (!CloudCommandDecoder::Decode(msg, cmd)) {
+                if (!msg.empty() && logger) logger->Error(Tag::Untagged, StdString("[CloudOperations] RetrieveCommands: malformed command payload"));
+                continue;
+            }
+            if (cmd.done) {
                 //Serial.println("[CloudOperations] Payload treated as done marker");
                 if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] RetrieveCommands: done payload received"));
                 continue;
             }
-            StdString cmd = ParseCommandPayload(msg);
-            if (!cmd.empty()) {
-                //Serial.print("[CloudOperations] Parsed command: ");
-                //Serial.println(cmd.c_str());
-                out.push_back(cmd);
+            if (cmd.value.empty()) {
+                continue;
             }
+            if (cmd.keyExplicit && !seenCommandKeys_.Insert(cmd.key)) {
+                // Redelivered (e.g. retained or re-published after reconnect); already handed out.
+                continue;
+            }
+            out.push_back(std::move(cmd));
         }
         //Serial.print("[CloudOperations] Returning command count=");
         //Serial.println(static_cast<Int>(out.size()));
@@ -58,9 +82,9 @@ class CloudOperations : public ICloudOperations {
     }
 
     Public Bool PublishLogs(const StdMap<ULongLong, StdString>& logs) override {
-        if (dirty_.load(std::memory_order_relaxed)) {
+        if (IsDirty()) {
             // Intentionally silent for high-frequency path.
-            if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] PublishLogs skip: dirty"));
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] PublishLogs skip: circuit open"));
             return false;
         }
         if (operationInProgress_.exchange(true)) {
@@ -76,19 +100,11 @@ class CloudOperations : public ICloudOperations {
         }
         if (logs.empty()) return true;
         //if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] PublishLogs: publishing ") + std::to_string(logs.size()) + " log(s)");
-        JsonDocument doc;
-        JsonObject root = doc.to<JsonObject>();
-        for (const auto& p : logs) {
-            root[std::to_string(p.first).c_str()] = p.second.c_str();
-        }
-        char buf[4900];
-        size_t n = serializeJson(doc, buf, sizeof(buf));
-        if (n >= sizeof(buf)) {
-            Serial.println("[CloudOperations] PublishLogs failed: payload too large");
-            if (logger) logger->Error(Tag::Untagged, StdString("[CloudOperations] PublishLogs: serialized payload too large"));
+        StdString payload;
+        if (!SerializeLogs(logs, payload)) {
             return false;
         }
-        Bool ok = awsIotCoreOperations_->SendMessage(StdString(buf, n));
+        Bool ok = awsIotCoreOperations_->SendMessage(payload);
         if (!ok) {
             Serial.println("[CloudOperations] PublishLogs failed: send message");
         }
@@ -98,43 +114,193 @@ class CloudOperations : public ICloudOperations {
         return ok;
     }
 
+    Public Bool PublishLogs(const StdMap<ULongLong, StdString>& logs, StdVector<CloudPublishCompletion>& completed) override {
+        completed.clear();
+        if (IsDirty()) {
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] PublishLogs skip: circuit open"));
+            return false;
+        }
+        if (operationInProgress_.exchange(true)) {
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] PublishLogs skip: operation already in progress"));
+            return false;
+        }
+        struct Guard { std::atomic<bool>& f; ~Guard() { f.store(false); } } g{operationInProgress_};
+        if (awsIotCoreOperations_ == nullptr) {
+            if (logger) logger->Error(Tag::Untagged, StdString("[CloudOperations] PublishLogs: awsIotCoreOperations not available"));
+            return false;
+        }
+        CollectCompletions(completed);
+        if (logs.empty()) return true;
+        StdString payload;
+        if (!SerializeLogs(logs, payload)) {
+            return false;
+        }
+        uint16_t packetId = awsIotCoreOperations_->SendMessageAtLeastOnce(payload);
+        if (packetId == 0) {
+            if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] PublishLogs: at-least-once publish not accepted"));
+            return false;
+        }
+        inflightBatches_[packetId] = InflightBatch{logs.begin()->first, logs.size()};
+        // Acknowledgements that arrived while publishing are reported right away.
+        CollectCompletions(completed);
+        return true;
+    }
+
+    Public Void SoftReset() override {
+        if (awsIotCoreOperations_ != nullptr) awsIotCoreOperations_->ResetCircuit();
+    }
+
+    Public Bool Prewarm() override {
+        if (IsDirty() || awsIotCoreOperations_ == nullptr) {
+            return false;
+        }
+        if (operationInProgress_.exchange(true)) {
+            return false;
+        }
+        struct Guard { std::atomic<bool>& f; ~Guard() { f.store(false); } } g{operationInProgress_};
+        Bool ok = awsIotCoreOperations_->Connect();
+        if (logger) logger->Info(Tag::Untagged, StdString("[CloudOperations] Prewarm ") + (ok ? "connected" : "failed"));
+        return ok;
+    }
+
+    Public Bool IsConnected() const override {
+        return awsIotCoreOperations_ != nullptr && awsIotCoreOperations_->IsConnected();
+    }
+
     Public Bool IsOperationInProgress() const override {
         return operationInProgress_.load(std::memory_order_relaxed);
     }
 
     Public Bool IsDirty() const override {
-        return dirty_.load(std::memory_order_relaxed);
+        return awsIotCoreOperations_ != nullptr && awsIotCoreOperations_->IsCircuitOpen();
+    }
+
+    Public ULong GetDroppedCommandCount() const override {
+        ULong dropped = droppedUndelivered_.load();
+        if (awsIotCoreOperations_ != nullptr) dropped += awsIotCoreOperations_->GetDroppedMessageCount();
+        return dropped;
+    }
+
+    Public CircuitBreakerStats GetCircuitStats() const override {
+        if (awsIotCoreOperations_ == nullptr) return CircuitBreakerStats{CircuitState::Closed, 0, 0, 0, 0, 0, 0, 0, 0};
+        return awsIotCoreOperations_->GetCircuitStats();
     }
 
     /* @Autowired */
     Private IAwsIotCoreOperationsPtr awsIotCoreOperations_;
     /* @Autowired */
+    Private IAwsIotCoreConfigProviderPtr configProvider_;
+    /* @Autowired */
     Private ILoggerPtr logger;
     Private std::atomic<bool> operationInProgress_{false};
-    Private std::atomic<bool> dirty_{false};
+    /** Received payloads not yet handed out, oldest first; keys are only marked seen when handed out.
+     *  Only touched under operationInProgress_. */
+    Private std::deque<StdString> undelivered_;
+    /** Cap on undelivered_; the oldest payload is dropped to make room. */
+    Private Static constexpr Size kMaxUndelivered = 32;
+    Private std::atomic<ULong> droppedUndelivered_{0};
+    /** Recently handed-out command keys. Only touched under operationInProgress_. */
+    Private CommandKeyDeduplicator<64> seenCommandKeys_;
 
-    Private Bool IsDonePayload(CStdString payload) {
-        if (payload.empty()) return false;
-        StdString s(payload);
-        if (s == "done") return true;
-        JsonDocument doc;
-        if (deserializeJson(doc, payload.c_str(), payload.length())) return false;
-        if (doc["done"].is<bool>() && doc["done"].as<bool>()) return true;
-        return false;
+    Private struct InflightBatch {
+        ULongLong firstLogKey;
+        Size logCount;
+    };
+    /** At-least-once batches by MQTT packet id, until settled. */
+    Private StdMap<uint16_t, InflightBatch> inflightBatches_;
+
+    Private Void CollectCompletions(StdVector<CloudPublishCompletion>& out) {
+        for (const MqttPublishCompletion& c : awsIotCoreOperations_->TakePublishCompletions()) {
+            auto it = inflightBatches_.find(c.packetId);
+            if (it == inflightBatches_.end()) continue;
+            out.push_back(CloudPublishCompletion{it->second.firstLogKey, it->second.logCount, c.acknowledged});
+            inflightBatches_.erase(it);
+        }
+    }
+
+    Private Static constexpr Size kMaxPayloadSize = 4900;
+    /** Upper bound for a batch before compression; the compressed payload must still fit kMaxPayloadSize. */
+    Private Static constexpr Size kMaxUncompressedSize = 16384;
+
+    Private CloudWireFormat PublishWireFormat() const {
+        if (configProvider_ == nullptr) return CloudWireFormat::Json;
+        return configProvider_->GetWireFormat(configProvider_->GetConfig()->publishTopic);
+    }
+
+    Private Bool PublishCompressionEnabled() const {
+        if (configProvider_ == nullptr) return false;
+        return configProvider_->IsCompressionEnabled(configProvider_->GetConfig()->publishTopic);
     }
 
-    Private StdString ParseCommandPayload(CStdString payload) {
-        if (payload.empty()) return {};
+    Private Static Bool EncodeLogsJson(const StdMap<ULongLong, StdString>& logs, Size limit, StdString& out) {
         JsonDocument doc;
-        if (deserializeJson(doc, payload.c_str(), payload.length())) {
-            return StdString(payload);
+        JsonObject root = doc.to<JsonObject>();
+        Char key[TimestampFormatter::kBufferSize];
+        for (const auto& p : logs) {
+            TimestampFormatter::FormatDecimal(p.first, key, sizeof(key));
+            // Non-const char* so the document copies the key.
+            root[key] = p.second.c_str();
+        }
+        size_t n = measureJson(doc);
+        if (n >= limit) return false;
+        out.clear();
+        out.reserve(n);
+        serializeJson(doc, out);
+        return true;
+    }
+
+    /** MessagePack log batch: a map of integer timestamp keys to message strings. */
+    Private Static Bool EncodeLogsMsgPack(const StdMap<ULongLong, StdString>& logs, Size limit, StdString& out) {
+        out.resize(limit);
+        MsgPackWriter writer(reinterpret_cast<UInt8*>(&out[0]), limit);
+        writer.WriteMapHeader(static_cast<uint32_t>(logs.size()));
+        for (const auto& p : logs) {
+            writer.WriteUInt(p.first);
+            writer.WriteString(p.second);
         }
-        if (doc.containsKey("key") && doc.containsKey("value")) {
-            const char* k = doc["key"].as<const char*>();
-            const char* v = doc["value"].as<const char*>();
-            if (k && v) return StdString(k) + ":" + StdString(v);
+        if (writer.Overflowed()) return false;
+        out.resize(writer.Length());
+        return true;
+    }
+
+    /** Writes envelope + LZSS(body) into @p out. Returns false if the result exceeds kMaxPayloadSize. */
+    Private Static Bool CompressPayload(CloudWireFormat format, CStdString& body, StdString& out) {
+        out.resize(kMaxPayloadSize);
+        UInt8* buf = reinterpret_cast<UInt8*>(&out[0]);
+        CloudPayloadEnvelope::WriteHeader(buf, format, true);
+        // The encoder carries 2 KB of history; keep it off the caller's task stack.
+        std::unique_ptr<LzssEncoder<>> encoder(new LzssEncoder<>(buf + CloudPayloadEnvelope::kHeaderSize,
+                                                                   kMaxPayloadSize - CloudPayloadEnvelope::kHeaderSize));
+        encoder->Sink(body);
+        if (!encoder->Finish()) return false;
+        out.resize(CloudPayloadEnvelope::kHeaderSize + encoder->Length());
+        return true;
+    }
+
+    Private Bool SerializeLogs(const StdMap<ULongLong, StdString>& logs, StdString& out) {
+        CloudWireFormat format = PublishWireFormat();
+        Bool compress = PublishCompressionEnabled();
+        Size limit = compress ? kMaxUncompressedSize
+            : (format == CloudWireFormat::Json ? kMaxPayloadSize : kMaxPayloadSize - CloudPayloadEnvelope::kHeaderSize);
+        StdString body;
+        Bool ok = (format == CloudWireFormat::MessagePack)
+            ? EncodeLogsMsgPack(logs, limit, body)
+            : EncodeLogsJson(logs, limit, body);
+        if (ok && compress) {
+            ok = CompressPayload(format, body, out);
+        } else if (ok && format == CloudWireFormat::MessagePack) {
+            UInt8 header[CloudPayloadEnvelope::kHeaderSize];
+            CloudPayloadEnvelope::WriteHeader(header, format);
+            out.assign(reinterpret_cast<const Char*>(header), sizeof(header));
+            out += body;
+        } else if (ok) {
+            out.swap(body);
         }
-        return StdString(payload);
+        if (!ok) {
+            Serial.println("[CloudOperations] PublishLogs failed: payload too large");
+            if (logger) logger->Error(Tag::Untagged, StdString("[CloudOperations] PublishLogs: serialized payload too large"));
+        }
+        return ok;
     }
 };
 
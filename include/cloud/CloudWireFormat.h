@@ -0,0 +1,43 @@
+#ifndef CLOUDWIREFORMAT_H
+#define CLOUDWIREFORMAT_H
+
+#include <StandardDefines.h>
+
+/** Encoding of cloud command and log payloads on a topic. */
+enum class CloudWireFormat : UInt8 {
+    Json = 0,
+    MessagePack = 1
+};
+
+/**
+ * Binary payloads are prefixed with a two-byte envelope: kMagic, then a flags byte whose low nibble is the
+ * CloudWireFormat and whose kCompressedFlag bit marks an LZSS-compressed body (see LzssEncoder). 0xC1 is never emitted by MessagePack and cannot start JSON or text, so un-enveloped
+ * payloads stay JSON and existing publishers keep working.
+ */
+struct CloudPayloadEnvelope {
+    Public Static constexpr UInt8 kMagic = 0xC1;
+    Public Static constexpr Size kHeaderSize = 2;
+    Public Static constexpr UInt8 kFormatMask = 0x0F;
+    Public Static constexpr UInt8 kCompressedFlag = 0x10;
+
+    /** Writes the envelope header into @p out (at least kHeaderSize bytes). */
+    Public Static Void WriteHeader(UInt8* out, CloudWireFormat format, Bool compressed = false) {
+        out[0] = kMagic;
+        out[1] = static_cast<UInt8>((static_cast<UInt8>(format) & kFormatMask) | (compressed ? kCompressedFlag : 0));
+    }
+
+    /** Detects the payload format. Returns the offset of the body (0 for plain JSON/text). */
+    Public Static Size Detect(CStdString payload, CloudWireFormat& format, Bool& compressed) {
+        if (payload.size() >= kHeaderSize && static_cast<UInt8>(payload[0]) == kMagic) {
+            UInt8 flags = static_cast<UInt8>(payload[1]);
+            format = static_cast<CloudWireFormat>(flags & kFormatMask);
+            compressed = (flags & kCompressedFlag) != 0;
+            return kHeaderSize;
+        }
+        format = CloudWireFormat::Json;
+        compressed = false;
+        return 0;
+    }
+};
+
+#endif /* CLOUDWIREFORMAT_H */
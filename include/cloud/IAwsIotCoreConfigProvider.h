@@ -2,19 +2,22 @@
 #define IAWSIOTCORECONFIGPROVIDER_H
 
 #include <StandardDefines.h>
+#include "AwsIotCoreConfig.h"
+#include "CloudWireFormat.h"
 
-/** Provides AWS IoT Core connection config as StdString values. */
+/** Provides AWS IoT Core connection config as immutable snapshots. */
 DefineStandardPointers(IAwsIotCoreConfigProvider)
 class IAwsIotCoreConfigProvider {
     Public Virtual ~IAwsIotCoreConfigProvider() = default;
 
-    Public Virtual StdString GetEndpoint() const = 0;
-    Public Virtual StdString GetThingName() const = 0;
-    Public Virtual StdString GetCaCert() const = 0;
-    Public Virtual StdString GetDeviceCert() const = 0;
-    Public Virtual StdString GetPrivateKey() const = 0;
-    Public Virtual StdString GetPublishTopic() const = 0;
-    Public Virtual StdString GetSubscribeTopic() const = 0;
+    /** Current snapshot; never null. Cheap to call, the returned views stay valid while the pointer is held. */
+    Public Virtual AwsIotCoreConfigPtr GetConfig() const = 0;
+    /** Re-reads the backing store if it changed and publishes a new snapshot. Returns true if one was published. */
+    Public Virtual Bool Refresh() = 0;
+    /** Payload encoding used when publishing on @p topicName. Inbound payloads are self-describing. */
+    Public Virtual CloudWireFormat GetWireFormat(CStdString topicName) const = 0;
+    /** True to LZSS-compress payloads published on @p topicName. */
+    Public Virtual Bool IsCompressionEnabled(CStdString topicName) const = 0;
 };
 
 #endif /* IAWSIOTCORECONFIGPROVIDER_H */
@@ -2,6 +2,15 @@
 #define IAWSIOTCOREOPERATIONS_H
 
 #include <StandardDefines.h>
+#include "MqttTopicRouter.h"
+#include "../common/CircuitBreaker.h"
+
+/** Outcome of a QoS 1 publish: acknowledged by the broker, or given up after the retry budget. */
+struct MqttPublishCompletion {
+    uint16_t packetId;
+    Bool acknowledged;
+    UInt attempts;
+};
 
 DefineStandardPointers(IAwsIotCoreOperations)
 class IAwsIotCoreOperations {
@@ -11,7 +20,46 @@ class IAwsIotCoreOperations {
     Public Virtual StdVector<StdString> ReceiveMessages() = 0;
 
     Public Virtual Bool SendMessage(CStdString message, CStdString topicName) = 0;
+    /** Returns and clears the messages buffered for @p topicName; each buffer keeps only the newest messages. */
     Public Virtual StdVector<StdString> ReceiveMessages(CStdString topicName) = 0;
+
+    /** Messages dropped (oldest first) because a ReceiveMessages() buffer was full. */
+    Public Virtual ULong GetDroppedMessageCount() const = 0;
+
+    /**
+     * Calls @p handler for every inbound message matching @p topicFilter ('+' and '#' allowed) and keeps the
+     * broker subscription across reconnects. Handlers run inside the MQTT loop with the connection lock held,
+     * so they must be quick and must not call back into this instance. Returns the subscription id, or 0.
+     */
+    Public Virtual UInt Subscribe(CStdString topicFilter, MqttMessageHandler handler) = 0;
+
+    /** Removes a Subscribe() registration; the broker subscription is dropped with its last handler. */
+    Public Virtual Bool Unsubscribe(UInt subscriptionId) = 0;
+
+    /**
+     * QoS 1 publish to the default topic. Returns the packet id, or 0 if not sent (not connected, or window full,
+     * which includes settled publishes not yet collected with TakePublishCompletions).
+     */
+    Public Virtual uint16_t SendMessageAtLeastOnce(CStdString message) = 0;
+    Public Virtual uint16_t SendMessageAtLeastOnce(CStdString message, CStdString topicName) = 0;
+
+    /** Resolves the broker, opens TLS, sends CONNECT and subscribes the default topic now instead of on first use. Returns true once connected. */
+    Public Virtual Bool Connect() = 0;
+
+    /** True if the MQTT session was up at the last connection check. */
+    Public Virtual Bool IsConnected() const = 0;
+
+    /** True while broker connection attempts are suspended after repeated failures. */
+    Public Virtual Bool IsCircuitOpen() const = 0;
+
+    /** Closes the circuit so the next call may connect right away. */
+    Public Virtual Void ResetCircuit() = 0;
+
+    /** Connection attempt outcomes, error rate and latency. */
+    Public Virtual CircuitBreakerStats GetCircuitStats() const = 0;
+
+    /** Returns and clears QoS 1 publishes settled since the last call. */
+    Public Virtual StdVector<MqttPublishCompletion> TakePublishCompletions() = 0;
 };
 
 #endif /* IAWSIOTCOREOPERATIONS_H */
@@ -3,26 +3,80 @@
 
 #include <StandardDefines.h>
 #include "ICloudOperations.h"
+#include "../common/BoundedMpscQueue.h"
+
+enum class CloudReadinessState : UInt8 {
+    /** Cloud operations are stopped. */
+    Stopped,
+    /** Started without pre-warming; the connection is made on first use. */
+    Cold,
+    /** Pre-warm task is connecting. */
+    Warming,
+    /** Broker session is up. */
+    Ready,
+    /** Pre-warm failed; the connection is retried on first use. */
+    Failed
+};
+
+struct CloudReadiness {
+    CloudReadinessState state;
+    /** millis() of the last StartCloudOperations. */
+    ULong startedAtMs;
+    /** Start to connected via pre-warm; 0 until then or without pre-warm. */
+    ULong connectLatencyMs;
+    /** Start to the first command handed out; 0 until then. */
+    ULong firstCommandLatencyMs;
+};
 
 DefineStandardPointers(ICloudFacade)
 
 class ICloudFacade {
     Public Virtual ~ICloudFacade() = default;
 
-    /** Returns the next command to execute, or empty string if none. */
-    Public Virtual StdString GetCommand() = 0;
+    /** Moves the next command to execute into @p out. Returns false if there is none. */
+    Public Virtual Bool GetCommand(CloudCommand& out) = 0;
+
+    /** Appends up to @p max queued commands to @p out, polling the cloud at most once when the queue is empty. Returns the count appended. */
+    Public Virtual Size GetCommands(Size max, StdVector<CloudCommand>& out) = 0;
+
+    /** Polls the cloud on a background task so the next GetCommand/GetCommands finds commands queued. No-op if a prefetch is running. */
+    Public Virtual Void PrefetchCommands() = 0;
 
     /** Publish logs to cloud. Returns true on success, false on failure. */
     Public Virtual Bool PublishLogs(const StdMap<ULongLong, StdString>& logs) = 0;
 
+    /** At-least-once publish; @param completed receives earlier batches settled since the last call. See ICloudOperations. */
+    Public Virtual Bool PublishLogs(const StdMap<ULongLong, StdString>& logs, StdVector<CloudPublishCompletion>& completed) = 0;
+
     Public Virtual Void ResetCloudOperations() = 0;
 
     Public Virtual Void StopCloudOperations() = 0;
 
     Public Virtual Void StartCloudOperations() = 0;
 
-    /** Returns true if the underlying cloud operations instance is dirty (e.g. after an error). */
+    /**
+     * When enabled, StartCloudOperations connects and subscribes on a background task instead of on the first
+     * GetCommand/PublishLogs. Off unless built with -DCLOUD_PREWARM_ON_START.
+     */
+    Public Virtual Void SetPrewarmOnStart(Bool enabled) = 0;
+
+    /** Connection readiness and start-to-connected / start-to-first-command latencies. */
+    Public Virtual CloudReadiness GetReadiness() const = 0;
+
+    /** Bounds for adaptive polling: the cloud is polled every @p floorMs after a command arrives, backing off exponentially to @p ceilingMs while idle. */
+    Public Virtual Void SetPollInterval(ULong floorMs, ULong ceilingMs) = 0;
+
+    /**
+     * Capacity, depth, high-water mark and overflow drops of the pending-command queue. Drops also include received
+     * payloads discarded oldest-first by the bounded receive buffers in front of it.
+     */
+    Public Virtual QueueStats GetCommandQueueStats() const = 0;
+
+    /** Returns true while the broker connection circuit is open after repeated failures. */
     Public Virtual Bool IsDirty() const = 0;
+
+    /** Broker connection circuit state, error rate and latency. */
+    Public Virtual CircuitBreakerStats GetCircuitStats() const = 0;
 };
 
 #endif /* ICLOUDFACADE_H */
@@ -2,23 +2,54 @@
 #define ICLOUDOPERATIONS_H
 
 #include <StandardDefines.h>
+#include "CloudCommand.h"
+#include "../common/CircuitBreaker.h"
+
+/** Delivery outcome of a batch published with PublishLogs(logs, completed). */
+struct CloudPublishCompletion {
+    /** Smallest log key of the batch. */
+    ULongLong firstLogKey;
+    Size logCount;
+    /** True if the broker acknowledged the batch; false if it was given up after retries. */
+    Bool acknowledged;
+};
 
 /** Cloud operations interface: returns data/boolean instead of result enums. */
 DefineStandardPointers(ICloudOperations)
 class ICloudOperations {
     Public Virtual ~ICloudOperations() = default;
 
-    /** Returns commands from cloud (e.g. list of "key:value" strings). Returns empty vector on failure or when not ready. */
-    Public Virtual StdVector<StdString> RetrieveCommands() = 0;
+    /** Returns at most @p max decoded commands from cloud (done markers excluded); later messages are kept for the next
+     *  call. Returns empty vector on failure or when not ready. */
+    Public Virtual StdVector<CloudCommand> RetrieveCommands(Size max) = 0;
 
     /** Publish logs to cloud at /logs. Map key = unique timestamp+seq (ULongLong), value = message. Returns true on success. */
     Public Virtual Bool PublishLogs(const StdMap<ULongLong, StdString>& logs) = 0;
 
-    /** Returns true if RetrieveCommands or PublishLogs is currently running. */
+    /** At-least-once variant: returns true once the batch is in flight (false if not ready or the in-flight window is full).
+     *  @param completed Receives batches from earlier calls that were acknowledged or given up since the last call. */
+    Public Virtual Bool PublishLogs(const StdMap<ULongLong, StdString>& logs, StdVector<CloudPublishCompletion>& completed) = 0;
+
+    /** Clears error state (closes the broker circuit) while keeping the MQTT session, in-flight batches and dedup state. */
+    Public Virtual Void SoftReset() = 0;
+
+    /** Connects to the broker and subscribes for commands now, so the first RetrieveCommands does not pay for it. Returns true once connected. */
+    Public Virtual Bool Prewarm() = 0;
+
+    /** True if the broker session was up at the last connection check. */
+    Public Virtual Bool IsConnected() const = 0;
+
+    /** Returns true if RetrieveCommands, PublishLogs or Prewarm is currently running. */
     Public Virtual Bool IsOperationInProgress() const = 0;
 
-    /** Returns true if the instance is dirty (e.g. after an error). */
+    /** Returns true while the broker circuit is open after repeated failures; it half-opens by itself after a cooldown. */
     Public Virtual Bool IsDirty() const = 0;
+
+    /** Received command payloads dropped, oldest first, because a bounded buffer before RetrieveCommands was full. */
+    Public Virtual ULong GetDroppedCommandCount() const = 0;
+
+    /** Broker connection circuit state, error rate and latency. */
+    Public Virtual CircuitBreakerStats GetCircuitStats() const = 0;
 };
 
 #endif /* ICLOUDOPERATIONS_H */
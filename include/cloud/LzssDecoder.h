@@ -0,0 +1,49 @@
+#ifndef LZSSDECODER_H
+#define LZSSDECODER_H
+
+#include <StandardDefines.h>
+
+/**
+ * Decoder for LzssEncoder output with the same WindowBits/LookaheadBits. Back-references are resolved
+ * against the output itself, so it needs no working memory beyond the caller's buffer.
+ */
+template <UInt WindowBits = 10, UInt LookaheadBits = 5>
+class LzssDecoder {
+    Private Static constexpr Size kMinMatch = 2;
+
+    /**
+     * Decodes @p in into @p out. Returns false for a corrupt stream or once the output would exceed
+     * @p maxOutput bytes; a back-reference expands up to kMinMatch + 2^LookaheadBits - 1 times its own size.
+     */
+    Public Static Bool Decode(const UInt8* in, Size inLen, StdString& out, Size maxOutput) {
+        Size bitPos = 0;
+        const Size totalBits = inLen * 8;
+        auto getBits = [&](UInt bits) -> uint32_t {
+            uint32_t v = 0;
+            for (UInt i = 0; i < bits; ++i, ++bitPos) {
+                v = (v << 1) | ((in[bitPos >> 3] >> (7 - (bitPos & 7))) & 1u);
+            }
+            return v;
+        };
+        out.clear();
+        // Anything shorter than a literal token is end-of-stream padding.
+        while (totalBits - bitPos >= 9) {
+            if (getBits(1) == 1) {
+                if (out.size() >= maxOutput) return false;
+                out += static_cast<Char>(getBits(8));
+                continue;
+            }
+            if (totalBits - bitPos < WindowBits + LookaheadBits) break;
+            Size distance = getBits(WindowBits) + 1;
+            Size len = getBits(LookaheadBits) + kMinMatch;
+            if (distance > out.size() || len > maxOutput - out.size()) return false;
+            Size from = out.size() - distance;
+            for (Size i = 0; i < len; ++i) {
+                out += out[from + i];
+            }
+        }
+        return true;
+    }
+};
+
+#endif /* LZSSDECODER_H */
@@ -0,0 +1,126 @@
+#ifndef LZSSENCODER_H
+#define LZSSENCODER_H
+
+#include <StandardDefines.h>
+#include <cstring>
+
+/**
+ * Streaming LZSS compressor (heatshrink-style bitstream) with a bounded window, writing into a caller buffer.
+ * Tokens: '1' + 8-bit literal, or '0' + WindowBits-bit (distance - 1) + LookaheadBits-bit (length - kMinMatch).
+ * Working memory is 2 << WindowBits bytes; no allocation. Feed input with Sink(), then call Finish() once.
+ */
+template <UInt WindowBits = 10, UInt LookaheadBits = 5>
+class LzssEncoder {
+    Public Static constexpr Size kWindowSize = static_cast<Size>(1) << WindowBits;
+    Public Static constexpr Size kMinMatch = 2;
+    Public Static constexpr Size kMaxMatch = kMinMatch + (static_cast<Size>(1) << LookaheadBits) - 1;
+
+    static_assert(kMaxMatch <= kWindowSize, "lookahead must fit in the window");
+
+    Private UInt8 history_[2 * kWindowSize];
+    Private Size pos_ = 0;
+    Private Size end_ = 0;
+
+    Private UInt8* out_;
+    Private Size capacity_;
+    Private Size length_ = 0;
+    Private Size inputLength_ = 0;
+    Private uint32_t bitBuffer_ = 0;
+    Private UInt bitCount_ = 0;
+    Private Bool overflowed_ = false;
+
+    Private Void PutBits(uint32_t value, UInt bits) {
+        bitBuffer_ = (bitBuffer_ << bits) | (value & ((1u << bits) - 1));
+        bitCount_ += bits;
+        while (bitCount_ >= 8) {
+            bitCount_ -= 8;
+            if (length_ >= capacity_) {
+                overflowed_ = true;
+                continue;
+            }
+            out_[length_++] = static_cast<UInt8>(bitBuffer_ >> bitCount_);
+        }
+    }
+
+    /** Longest match for history_[pos_] within the window; returns its length and sets @p distance. */
+    Private Size FindMatch(Size available, Size& distance) const {
+        Size limit = available < kMaxMatch ? available : kMaxMatch;
+        if (limit < kMinMatch) return 0;
+        Size start = pos_ > kWindowSize ? pos_ - kWindowSize : 0;
+        Size best = 0;
+        const UInt8* cur = history_ + pos_;
+        for (Size cand = pos_; cand-- > start;) {
+            const UInt8* p = history_ + cand;
+            if (p[0] != cur[0] || p[best] != cur[best]) continue;
+            Size len = 1;
+            while (len < limit && p[len] == cur[len]) ++len;
+            if (len > best) {
+                best = len;
+                distance = pos_ - cand;
+                if (best == limit) break;
+            }
+        }
+        return best >= kMinMatch ? best : 0;
+    }
+
+    /** Emits tokens while at least @p keep bytes of lookahead remain buffered. */
+    Private Void Encode(Size keep) {
+        while (end_ - pos_ > keep) {
+            Size distance = 0;
+            Size len = FindMatch(end_ - pos_, distance);
+            if (len == 0) {
+                PutBits(1, 1);
+                PutBits(history_[pos_], 8);
+                ++pos_;
+            } else {
+                PutBits(0, 1);
+                PutBits(static_cast<uint32_t>(distance - 1), WindowBits);
+                PutBits(static_cast<uint32_t>(len - kMinMatch), LookaheadBits);
+                pos_ += len;
+            }
+        }
+    }
+
+    Public LzssEncoder(UInt8* out, Size capacity) : out_(out), capacity_(capacity) {}
+
+    Public Size Length() const { return length_; }
+
+    Public Size InputLength() const { return inputLength_; }
+
+    Public Bool Overflowed() const { return overflowed_; }
+
+    Public Void Sink(const UInt8* data, Size len) {
+        inputLength_ += len;
+        while (len > 0 && !overflowed_) {
+            if (end_ == sizeof(history_)) {
+                // Keep exactly one window of history behind the encode position.
+                Size shift = pos_ - kWindowSize;
+                memmove(history_, history_ + shift, end_ - shift);
+                pos_ -= shift;
+                end_ -= shift;
+            }
+            Size n = sizeof(history_) - end_;
+            if (n > len) n = len;
+            memcpy(history_ + end_, data, n);
+            end_ += n;
+            data += n;
+            len -= n;
+            Encode(kMaxMatch - 1);
+        }
+    }
+
+    Public Void Sink(CStdString& data) {
+        Sink(reinterpret_cast<const UInt8*>(data.data()), data.size());
+    }
+
+    /** Flushes the remaining input and pads the last byte with zero bits. Returns false on overflow. */
+    Public Bool Finish() {
+        Encode(0);
+        if (bitCount_ > 0) {
+            PutBits(0, 8 - bitCount_);
+        }
+        return !overflowed_;
+    }
+};
+
+#endif /* LZSSENCODER_H */
@@ -0,0 +1,155 @@
+#ifndef MQTTACKTRACKINGCLIENT_H
+#define MQTTACKTRACKINGCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <StandardDefines.h>
+#include <functional>
+
+/**
+ * Client decorator placed between PubSubClient and the TLS socket.
+ * Forwards all traffic unchanged and follows the inbound MQTT packet stream so PUBACKs,
+ * which PubSubClient reads and drops, are reported to the owner by packet id.
+ */
+class MqttAckTrackingClient : public Client {
+    Private Static constexpr UInt8 kPubackHeader = 0x40;
+
+    Private enum class FrameState : UInt8 { Header, Length, Body };
+
+    Private Client& inner_;
+    Private std::function<Void(uint16_t)> onPuback_;
+
+    Private FrameState state_ = FrameState::Header;
+    Private UInt8 header_ = 0;
+    Private UInt remaining_ = 0;
+    Private UInt lengthShift_ = 0;
+    Private UInt bodyIndex_ = 0;
+    Private uint16_t packetId_ = 0;
+
+    Private Void ResetFrame() {
+        state_ = FrameState::Header;
+        header_ = 0;
+        remaining_ = 0;
+        lengthShift_ = 0;
+        bodyIndex_ = 0;
+        packetId_ = 0;
+    }
+
+    Private Void OnFrameComplete() {
+        if (header_ == kPubackHeader && bodyIndex_ == 2 && onPuback_) {
+            onPuback_(packetId_);
+        }
+        ResetFrame();
+    }
+
+    Private Void Track(UInt8 b) {
+        switch (state_) {
+            case FrameState::Header:
+                header_ = b;
+                state_ = FrameState::Length;
+                break;
+            case FrameState::Length:
+                remaining_ |= static_cast<UInt>(b & 0x7F) << lengthShift_;
+                lengthShift_ += 7;
+                if ((b & 0x80) == 0) {
+                    if (remaining_ == 0) {
+                        OnFrameComplete();
+                    } else {
+                        state_ = FrameState::Body;
+                    }
+                } else if (lengthShift_ > 21) {
+                    // Malformed length; resynchronise on the next byte.
+                    ResetFrame();
+                }
+                break;
+            case FrameState::Body:
+                if (header_ == kPubackHeader && bodyIndex_ < 2) {
+                    packetId_ = static_cast<uint16_t>((packetId_ << 8) | b);
+                }
+                ++bodyIndex_;
+                if (bodyIndex_ >= remaining_) {
+                    OnFrameComplete();
+                }
+                break;
+        }
+    }
+
+    Public Explicit MqttAckTrackingClient(Client& inner) : inner_(inner) {}
+
+    /** Handler invoked with the packet id of every PUBACK read by the MQTT client. */
+    Public Void SetPubackHandler(std::function<Void(uint16_t)> handler) {
+        onPuback_ = std::move(handler);
+    }
+
+    Public int connect(IPAddress ip, uint16_t port) override {
+        ResetFrame();
+        return inner_.connect(ip, port);
+    }
+
+    Public int connect(const char* host, uint16_t port) override {
+        ResetFrame();
+        return inner_.connect(host, port);
+    }
+
+    // Present as pure virtuals on newer cores only, hence no override specifier.
+    Public int connect(IPAddress ip, uint16_t port, int32_t timeout) {
+        (void)timeout;
+        return connect(ip, port);
+    }
+
+    Public int connect(const char* host, uint16_t port, int32_t timeout) {
+        (void)timeout;
+        return connect(host, port);
+    }
+
+    Public size_t write(uint8_t b) override {
+        return inner_.write(b);
+    }
+
+    Public size_t write(const uint8_t* buf, size_t size) override {
+        return inner_.write(buf, size);
+    }
+
+    Public int available() override {
+        return inner_.available();
+    }
+
+    Public int read() override {
+        int b = inner_.read();
+        if (b >= 0) {
+            Track(static_cast<UInt8>(b));
+        }
+        return b;
+    }
+
+    Public int read(uint8_t* buf, size_t size) override {
+        int n = inner_.read(buf, size);
+        for (int i = 0; i < n; ++i) {
+            Track(buf[i]);
+        }
+        return n;
+    }
+
+    Public int peek() override {
+        return inner_.peek();
+    }
+
+    Public Void flush() override {
+        inner_.flush();
+    }
+
+    Public Void stop() override {
+        inner_.stop();
+        ResetFrame();
+    }
+
+    Public uint8_t connected() override {
+        return inner_.connected();
+    }
+
+    Public operator bool() override {
+        return static_cast<bool>(inner_);
+    }
+};
+
+#endif /* MQTTACKTRACKINGCLIENT_H */
@@ -0,0 +1,108 @@
+#ifndef MQTTINFLIGHTWINDOW_H
+#define MQTTINFLIGHTWINDOW_H
+
+#include <StandardDefines.h>
+#include "IAwsIotCoreOperations.h"
+
+/**
+ * Fixed-size window of QoS 1 PUBLISH packets awaiting PUBACK.
+ * Each slot keeps the encoded packet so retransmission only flips the DUP flag and rewrites it.
+ * Not thread-safe; the owner serialises access (AwsIotCoreOperations holds the MQTT mutex).
+ */
+template <Size Capacity>
+class MqttInflightWindow {
+    Private struct Entry {
+        Bool used = false;
+        uint16_t packetId = 0;
+        StdString packet;
+        ULong lastSentMs = 0;
+        UInt attempts = 0;
+    };
+
+    /** Settled publishes the owner has not collected yet; while this many are held, Add is refused. */
+    Private Static constexpr Size kMaxPendingCompletions = Capacity * 4;
+
+    Private Entry entries_[Capacity];
+    Private Size count_ = 0;
+    Private StdVector<MqttPublishCompletion> completions_;
+
+    Private Void Complete(Entry& e, Bool acknowledged) {
+        // Never dropped: Add keeps count_ + completions_ within kMaxPendingCompletions.
+        completions_.push_back(MqttPublishCompletion{e.packetId, acknowledged, e.attempts});
+        e.used = false;
+        e.packet.clear();
+        e.packet.shrink_to_fit();
+        --count_;
+    }
+
+    /** True while no slot is free or the owner has not collected enough completions. */
+    Public Bool IsFull() const {
+        return count_ >= Capacity || count_ + completions_.size() >= kMaxPendingCompletions;
+    }
+
+    Public Size Count() const { return count_; }
+
+    Public Bool Contains(uint16_t packetId) const {
+        for (const Entry& e : entries_) {
+            if (e.used && e.packetId == packetId) return true;
+        }
+        return false;
+    }
+
+    /** Takes ownership of an already-sent packet. Returns false when the window is full. */
+    Public Bool Add(uint16_t packetId, StdString&& packet, ULong nowMs) {
+        if (IsFull()) return false;
+        for (Entry& e : entries_) {
+            if (e.used) continue;
+            e.used = true;
+            e.packetId = packetId;
+            e.packet = std::move(packet);
+            e.lastSentMs = nowMs;
+            e.attempts = 1;
+            ++count_;
+            return true;
+        }
+        return false;
+    }
+
+    /** Settles the packet as delivered. Returns false for unknown or duplicate acknowledgements. */
+    Public Bool Acknowledge(uint16_t packetId) {
+        for (Entry& e : entries_) {
+            if (e.used && e.packetId == packetId) {
+                Complete(e, true);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Calls @p resend(packet) for every entry unacknowledged for at least @p timeoutMs (all entries when
+     * @p force). Entries that already used @p maxAttempts are settled as failed instead of resent.
+     */
+    template <typename ResendFn>
+    Void ServiceRetries(ULong nowMs, ULong timeoutMs, UInt maxAttempts, Bool force, ResendFn resend) {
+        for (Entry& e : entries_) {
+            if (!e.used) continue;
+            if (!force && nowMs - e.lastSentMs < timeoutMs) continue;
+            if (e.attempts >= maxAttempts) {
+                Complete(e, false);
+                continue;
+            }
+            e.packet[0] = static_cast<Char>(static_cast<UInt8>(e.packet[0]) | 0x08);
+            if (resend(e.packet)) {
+                e.lastSentMs = nowMs;
+                ++e.attempts;
+            }
+        }
+    }
+
+    /** Returns and clears the publishes settled since the last call. */
+    Public StdVector<MqttPublishCompletion> TakeCompletions() {
+        StdVector<MqttPublishCompletion> out;
+        out.swap(completions_);
+        return out;
+    }
+};
+
+#endif /* MQTTINFLIGHTWINDOW_H */
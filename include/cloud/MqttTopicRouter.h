@@ -0,0 +1,231 @@
+#ifndef MQTTTOPICROUTER_H
+#define MQTTTOPICROUTER_H
+
+#include <StandardDefines.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+/** Receives one inbound message; @p topic is NUL-terminated, @p payload may contain zero bytes. */
+typedef std::function<Void(const Char* topic, const UInt8* payload, UInt length)> MqttMessageHandler;
+
+/**
+ * Routes inbound MQTT messages to handlers registered against topic filters, with MQTT 3.1.1 '+' and '#'
+ * wildcards. Filters are stored as a trie with one node per topic level, so a dispatch walks the topic's
+ * levels (plus the wildcard branches) and costs O(depth * log fan-out) regardless of how many filters exist.
+ * Not thread-safe, and handlers must not subscribe or unsubscribe; the owner serialises access
+ * (AwsIotCoreOperations holds the MQTT mutex).
+ */
+class MqttTopicRouter {
+    Private struct Node;
+
+    Private struct Child {
+        StdString level;
+        std::unique_ptr<Node> node;
+    };
+
+    Private struct Route {
+        UInt id;
+        MqttMessageHandler handler;
+    };
+
+    Private struct Node {
+        /** Literal levels, sorted for binary search. */
+        StdVector<Child> children;
+        std::unique_ptr<Node> plus;
+        /** Filters ending here ("a/b") and filters ending in '#' under this node ("a/b/#"). */
+        StdVector<Route> exact;
+        StdVector<Route> hash;
+
+        Bool IsEmpty() const {
+            return children.empty() && !plus && exact.empty() && hash.empty();
+        }
+    };
+
+    Private Node root_;
+    Private StdMap<UInt, StdString> filters_;
+    Private UInt nextId_ = 1;
+
+    Private Static Int CompareLevel(CStdString level, const Char* s, Size len) {
+        return level.compare(0, level.size(), s, len);
+    }
+
+    Private Static StdVector<Child>::iterator LowerBound(StdVector<Child>& children, const Char* s, Size len) {
+        return std::lower_bound(children.begin(), children.end(), 0,
+            [s, len](const Child& c, Int) { return CompareLevel(c.level, s, len) < 0; });
+    }
+
+    Private Static const Node* FindChild(const Node& node, const Char* s, Size len) {
+        auto it = std::lower_bound(node.children.begin(), node.children.end(), 0,
+            [s, len](const Child& c, Int) { return CompareLevel(c.level, s, len) < 0; });
+        if (it == node.children.end() || CompareLevel(it->level, s, len) != 0) return nullptr;
+        return it->node.get();
+    }
+
+    Private Static Node& GetOrAddChild(Node& node, const Char* s, Size len) {
+        auto it = LowerBound(node.children, s, len);
+        if (it != node.children.end() && CompareLevel(it->level, s, len) == 0) return *it->node;
+        Child child;
+        child.level.assign(s, len);
+        child.node.reset(new Node());
+        return *node.children.insert(it, std::move(child))->node;
+    }
+
+    Private Static Void Fire(const StdVector<Route>& routes, const Char* topic, const UInt8* payload, UInt length, Size& delivered) {
+        for (const Route& r : routes) {
+            r.handler(topic, payload, length);
+            ++delivered;
+        }
+    }
+
+    /** @p level points at the start of the current level, or is null once every level has been consumed. */
+    Private Static Void Match(const Node& node, const Char* level, const Char* topic, const UInt8* payload, UInt length, Size& delivered) {
+        // "a/#" also matches "a" itself.
+        Fire(node.hash, topic, payload, length, delivered);
+        if (level == nullptr) {
+            Fire(node.exact, topic, payload, length, delivered);
+            return;
+        }
+        const Char* end = strchr(level, '/');
+        Size len = end != nullptr ? static_cast<Size>(end - level) : strlen(level);
+        const Char* next = end != nullptr ? end + 1 : nullptr;
+        const Node* child = FindChild(node, level, len);
+        if (child != nullptr) Match(*child, next, topic, payload, length, delivered);
+        if (node.plus) Match(*node.plus, next, topic, payload, length, delivered);
+    }
+
+    /** Walks or creates the node for @p filter. Returns the node and whether the filter ends in '#'. */
+    Private Node& NodeFor(CStdString filter, Bool& isHash) {
+        Node* node = &root_;
+        isHash = false;
+        Size pos = 0;
+        for (;;) {
+            Size end = filter.find('/', pos);
+            Size len = (end == StdString::npos ? filter.size() : end) - pos;
+            if (len == 1 && filter[pos] == '#') {
+                isHash = true;
+                return *node;
+            }
+            if (len == 1 && filter[pos] == '+') {
+                if (!node->plus) node->plus.reset(new Node());
+                node = node->plus.get();
+            } else {
+                node = &GetOrAddChild(*node, filter.data() + pos, len);
+            }
+            if (end == StdString::npos) return *node;
+            pos = end + 1;
+        }
+    }
+
+    /** Removes route @p id under @p filter and prunes nodes left empty. Returns true if it was found. */
+    Private Static Bool Remove(Node& node, CStdString filter, Size pos, UInt id) {
+        Size end = filter.find('/', pos);
+        Size len = (end == StdString::npos ? filter.size() : end) - pos;
+        auto eraseFrom = [id](StdVector<Route>& routes) {
+            for (auto it = routes.begin(); it != routes.end(); ++it) {
+                if (it->id == id) {
+                    routes.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        };
+        if (len == 1 && filter[pos] == '#') return eraseFrom(node.hash);
+        Node* child;
+        StdVector<Child>::iterator literal = node.children.end();
+        if (len == 1 && filter[pos] == '+') {
+            child = node.plus.get();
+        } else {
+            literal = LowerBound(node.children, filter.data() + pos, len);
+            child = literal != node.children.end() && CompareLevel(literal->level, filter.data() + pos, len) == 0
+                ? literal->node.get() : nullptr;
+        }
+        if (child == nullptr) return false;
+        Bool removed = end == StdString::npos ? eraseFrom(child->exact) : Remove(*child, filter, end + 1, id);
+        if (removed && child->IsEmpty()) {
+            if (child == node.plus.get()) node.plus.reset();
+            else node.children.erase(literal);
+        }
+        return removed;
+    }
+
+    /**
+     * True for a well-formed filter: non-empty, '#' only as the whole last level, '+' only as a whole level.
+     */
+    Public Static Bool IsValidFilter(CStdString filter) {
+        if (filter.empty()) return false;
+        for (Size i = 0; i < filter.size(); ++i) {
+            Char c = filter[i];
+            if (c != '+' && c != '#') continue;
+            Bool levelStart = i == 0 || filter[i - 1] == '/';
+            Bool levelEnd = i + 1 == filter.size() || filter[i + 1] == '/';
+            if (!levelStart || !levelEnd) return false;
+            if (c == '#' && i + 1 != filter.size()) return false;
+        }
+        return true;
+    }
+
+    /** Registers @p handler for @p filter. Returns the subscription id, or 0 if the filter is invalid. */
+    Public UInt Subscribe(CStdString filter, MqttMessageHandler handler) {
+        if (!IsValidFilter(filter) || !handler) return 0;
+        if (nextId_ == 0) nextId_ = 1;
+        UInt id = nextId_++;
+        Bool isHash;
+        Node& node = NodeFor(filter, isHash);
+        (isHash ? node.hash : node.exact).push_back(Route{id, std::move(handler)});
+        filters_[id] = filter;
+        return id;
+    }
+
+    /** Removes subscription @p id and stores its filter in @p filterOut if given. Returns false if unknown. */
+    Public Bool Unsubscribe(UInt id, StdString* filterOut = nullptr) {
+        auto it = filters_.find(id);
+        if (it == filters_.end()) return false;
+        Remove(root_, it->second, 0, id);
+        if (filterOut != nullptr) *filterOut = it->second;
+        filters_.erase(it);
+        return true;
+    }
+
+    /** True if any subscription uses exactly @p filter. */
+    Public Bool HasFilter(CStdString filter) const {
+        for (const auto& p : filters_) {
+            if (p.second == filter) return true;
+        }
+        return false;
+    }
+
+    /** Distinct filters, e.g. to resubscribe after a new broker session. */
+    Public StdVector<StdString> Filters() const {
+        StdVector<StdString> out;
+        for (const auto& p : filters_) {
+            if (std::find(out.begin(), out.end(), p.second) == out.end()) out.push_back(p.second);
+        }
+        return out;
+    }
+
+    Public Size Count() const {
+        return filters_.size();
+    }
+
+    /**
+     * Calls every handler whose filter matches @p topic, once per subscription. Topics starting with '$' are
+     * not matched by filters starting with a wildcard. Returns the number of handlers called.
+     */
+    Public Size Dispatch(const Char* topic, const UInt8* payload, UInt length) const {
+        Size delivered = 0;
+        if (topic == nullptr || *topic == '\0') return 0;
+        if (*topic == '$') {
+            const Char* end = strchr(topic, '/');
+            Size len = end != nullptr ? static_cast<Size>(end - topic) : strlen(topic);
+            const Node* child = FindChild(root_, topic, len);
+            if (child != nullptr) Match(*child, end != nullptr ? end + 1 : nullptr, topic, payload, length, delivered);
+            return delivered;
+        }
+        Match(root_, topic, topic, payload, length, delivered);
+        return delivered;
+    }
+};
+
+#endif /* MQTTTOPICROUTER_H */
@@ -0,0 +1,185 @@
+#ifndef MSGPACKREADER_H
+#define MSGPACKREADER_H
+
+#include <StandardDefines.h>
+
+/** Value kinds reported by MsgPackReader::PeekType(). */
+enum class MsgPackType : UInt8 {
+    Nil,
+    Bool,
+    Integer,
+    Float,
+    String,
+    Binary,
+    Array,
+    Map,
+    Extension,
+    Invalid
+};
+
+/**
+ * Streaming MessagePack decoder over a caller-owned buffer. Strings are returned as views into that buffer,
+ * so they are valid only while it is. Every read fails (returns false) on malformed or truncated input.
+ */
+class MsgPackReader {
+    Private const UInt8* data_;
+    Private Size length_;
+    Private Size pos_ = 0;
+
+    Private Bool ReadBigEndian(Size bytes, uint64_t& out) {
+        if (length_ - pos_ < bytes) return false;
+        out = 0;
+        for (Size i = 0; i < bytes; ++i) {
+            out = (out << 8) | data_[pos_++];
+        }
+        return true;
+    }
+
+    Private Bool SkipBytes(uint64_t n) {
+        if (length_ - pos_ < n) return false;
+        pos_ += static_cast<Size>(n);
+        return true;
+    }
+
+    Public MsgPackReader(const UInt8* data, Size length) : data_(data), length_(length) {}
+
+    Public Bool AtEnd() const { return pos_ >= length_; }
+
+    Public Size Position() const { return pos_; }
+
+    Public MsgPackType PeekType() const {
+        if (pos_ >= length_) return MsgPackType::Invalid;
+        UInt8 b = data_[pos_];
+        if (b <= 0x7F || b >= 0xE0) return MsgPackType::Integer;
+        if (b <= 0x8F) return MsgPackType::Map;
+        if (b <= 0x9F) return MsgPackType::Array;
+        if (b <= 0xBF) return MsgPackType::String;
+        switch (b) {
+            case 0xC0: return MsgPackType::Nil;
+            case 0xC2: case 0xC3: return MsgPackType::Bool;
+            case 0xC4: case 0xC5: case 0xC6: return MsgPackType::Binary;
+            case 0xC7: case 0xC8: case 0xC9:
+            case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8: return MsgPackType::Extension;
+            case 0xCA: case 0xCB: return MsgPackType::Float;
+            case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+            case 0xD0: case 0xD1: case 0xD2: case 0xD3: return MsgPackType::Integer;
+            case 0xD9: case 0xDA: case 0xDB: return MsgPackType::String;
+            case 0xDC: case 0xDD: return MsgPackType::Array;
+            case 0xDE: case 0xDF: return MsgPackType::Map;
+            default: return MsgPackType::Invalid;
+        }
+    }
+
+    Public Bool ReadNil() {
+        if (PeekType() != MsgPackType::Nil) return false;
+        ++pos_;
+        return true;
+    }
+
+    Public Bool ReadBool(Bool& out) {
+        if (PeekType() != MsgPackType::Bool) return false;
+        out = data_[pos_++] == 0xC3;
+        return true;
+    }
+
+    /** Reads a non-negative integer of any width. */
+    Public Bool ReadUInt(uint64_t& out) {
+        if (pos_ >= length_) return false;
+        UInt8 b = data_[pos_];
+        if (b <= 0x7F) {
+            ++pos_;
+            out = b;
+            return true;
+        }
+        if (b < 0xCC || b > 0xCF) return false;
+        ++pos_;
+        return ReadBigEndian(static_cast<Size>(1) << (b - 0xCC), out);
+    }
+
+    Public Bool ReadMapHeader(uint32_t& count) {
+        if (pos_ >= length_) return false;
+        UInt8 b = data_[pos_];
+        uint64_t n = 0;
+        if (b >= 0x80 && b <= 0x8F) {
+            ++pos_;
+            count = b & 0x0F;
+            return true;
+        }
+        if (b != 0xDE && b != 0xDF) return false;
+        ++pos_;
+        if (!ReadBigEndian(b == 0xDE ? 2 : 4, n)) return false;
+        count = static_cast<uint32_t>(n);
+        return true;
+    }
+
+    /** Reads a str value as a view into the input buffer. */
+    Public Bool ReadString(const Char*& str, Size& len) {
+        if (pos_ >= length_) return false;
+        UInt8 b = data_[pos_];
+        uint64_t n = 0;
+        if (b >= 0xA0 && b <= 0xBF) {
+            ++pos_;
+            n = b & 0x1F;
+        } else if (b >= 0xD9 && b <= 0xDB) {
+            ++pos_;
+            if (!ReadBigEndian(static_cast<Size>(1) << (b - 0xD9), n)) return false;
+        } else {
+            return false;
+        }
+        if (length_ - pos_ < n) return false;
+        str = reinterpret_cast<const Char*>(data_ + pos_);
+        len = static_cast<Size>(n);
+        pos_ += len;
+        return true;
+    }
+
+    /** Skips one complete value, including nested containers. */
+    Public Bool Skip() {
+        Size pending = 1;
+        while (pending > 0) {
+            if (pos_ >= length_) return false;
+            UInt8 b = data_[pos_++];
+            --pending;
+            uint64_t n = 0;
+            if (b <= 0x7F || b >= 0xE0 || b == 0xC0 || b == 0xC2 || b == 0xC3) continue;
+            if (b <= 0x8F) { pending += 2 * (b & 0x0F); continue; }
+            if (b <= 0x9F) { pending += b & 0x0F; continue; }
+            if (b <= 0xBF) { if (!SkipBytes(b & 0x1F)) return false; continue; }
+            switch (b) {
+                case 0xC4: case 0xC5: case 0xC6:
+                    if (!ReadBigEndian(static_cast<Size>(1) << (b - 0xC4), n) || !SkipBytes(n)) return false;
+                    break;
+                case 0xC7: case 0xC8: case 0xC9:
+                    if (!ReadBigEndian(static_cast<Size>(1) << (b - 0xC7), n) || !SkipBytes(n + 1)) return false;
+                    break;
+                case 0xCA: if (!SkipBytes(4)) return false; break;
+                case 0xCB: if (!SkipBytes(8)) return false; break;
+                case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+                    if (!SkipBytes(static_cast<Size>(1) << (b - 0xCC))) return false;
+                    break;
+                case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+                    if (!SkipBytes(static_cast<Size>(1) << (b - 0xD0))) return false;
+                    break;
+                case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+                    if (!SkipBytes((static_cast<Size>(1) << (b - 0xD4)) + 1)) return false;
+                    break;
+                case 0xD9: case 0xDA: case 0xDB:
+                    if (!ReadBigEndian(static_cast<Size>(1) << (b - 0xD9), n) || !SkipBytes(n)) return false;
+                    break;
+                case 0xDC: case 0xDD:
+                    if (!ReadBigEndian(b == 0xDC ? 2 : 4, n)) return false;
+                    pending += static_cast<Size>(n);
+                    break;
+                case 0xDE: case 0xDF:
+                    if (!ReadBigEndian(b == 0xDE ? 2 : 4, n)) return false;
+                    pending += 2 * static_cast<Size>(n);
+                    break;
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif /* MSGPACKREADER_H */
@@ -0,0 +1,120 @@
+#ifndef MSGPACKWRITER_H
+#define MSGPACKWRITER_H
+
+#include <StandardDefines.h>
+#include <cstring>
+
+/**
+ * Streaming MessagePack encoder writing into a caller-supplied buffer. No allocation.
+ * Once a write does not fit, the writer is marked overflowed and all further writes fail.
+ */
+class MsgPackWriter {
+    Private UInt8* buffer_;
+    Private Size capacity_;
+    Private Size length_ = 0;
+    Private Bool overflowed_ = false;
+
+    Private Bool Reserve(Size n) {
+        if (overflowed_ || capacity_ - length_ < n) {
+            overflowed_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    Private Void PutByte(UInt8 b) {
+        buffer_[length_++] = b;
+    }
+
+    Private Void PutBigEndian(uint64_t v, Size bytes) {
+        for (Size i = bytes; i > 0; --i) {
+            buffer_[length_++] = static_cast<UInt8>(v >> ((i - 1) * 8));
+        }
+    }
+
+    Private Bool WriteTyped(UInt8 type, uint64_t v, Size bytes) {
+        if (!Reserve(1 + bytes)) return false;
+        PutByte(type);
+        PutBigEndian(v, bytes);
+        return true;
+    }
+
+    Public MsgPackWriter(UInt8* buffer, Size capacity) : buffer_(buffer), capacity_(capacity) {}
+
+    Public Size Length() const { return length_; }
+
+    Public Bool Overflowed() const { return overflowed_; }
+
+    Public Bool WriteNil() {
+        if (!Reserve(1)) return false;
+        PutByte(0xC0);
+        return true;
+    }
+
+    Public Bool WriteBool(Bool v) {
+        if (!Reserve(1)) return false;
+        PutByte(v ? 0xC3 : 0xC2);
+        return true;
+    }
+
+    Public Bool WriteUInt(uint64_t v) {
+        if (v < 0x80) {
+            if (!Reserve(1)) return false;
+            PutByte(static_cast<UInt8>(v));
+            return true;
+        }
+        if (v <= 0xFF) return WriteTyped(0xCC, v, 1);
+        if (v <= 0xFFFF) return WriteTyped(0xCD, v, 2);
+        if (v <= 0xFFFFFFFFULL) return WriteTyped(0xCE, v, 4);
+        return WriteTyped(0xCF, v, 8);
+    }
+
+    Public Bool WriteMapHeader(uint32_t count) {
+        if (count < 16) {
+            if (!Reserve(1)) return false;
+            PutByte(static_cast<UInt8>(0x80 | count));
+            return true;
+        }
+        if (count <= 0xFFFF) return WriteTyped(0xDE, count, 2);
+        return WriteTyped(0xDF, count, 4);
+    }
+
+    Public Bool WriteArrayHeader(uint32_t count) {
+        if (count < 16) {
+            if (!Reserve(1)) return false;
+            PutByte(static_cast<UInt8>(0x90 | count));
+            return true;
+        }
+        if (count <= 0xFFFF) return WriteTyped(0xDC, count, 2);
+        return WriteTyped(0xDD, count, 4);
+    }
+
+    Public Bool WriteString(const Char* s, Size len) {
+        Bool ok;
+        if (len < 32) {
+            ok = Reserve(1);
+            if (ok) PutByte(static_cast<UInt8>(0xA0 | len));
+        } else if (len <= 0xFF) {
+            ok = WriteTyped(0xD9, len, 1);
+        } else if (len <= 0xFFFF) {
+            ok = WriteTyped(0xDA, len, 2);
+        } else {
+            ok = WriteTyped(0xDB, len, 4);
+        }
+        return ok && WriteRaw(reinterpret_cast<const UInt8*>(s), len);
+    }
+
+    Public Bool WriteString(CStdString& s) {
+        return WriteString(s.data(), s.size());
+    }
+
+    /** Appends bytes verbatim (e.g. an envelope header or pre-encoded value). */
+    Public Bool WriteRaw(const UInt8* data, Size len) {
+        if (!Reserve(len)) return false;
+        if (len > 0) memcpy(buffer_ + length_, data, len);
+        length_ += len;
+        return true;
+    }
+};
+
+#endif /* MSGPACKWRITER_H */
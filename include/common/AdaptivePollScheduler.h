@@ -0,0 +1,62 @@
+#ifndef ADAPTIVEPOLLSCHEDULER_H
+#define ADAPTIVEPOLLSCHEDULER_H
+
+#include <StandardDefines.h>
+#include <atomic>
+
+/**
+ * Decides when a command source is worth polling. Polls at the floor interval right after a poll returns
+ * something, and doubles the interval on every empty poll up to the ceiling.
+ * Times are millis() values; wrap-around safe. Safe to share between the caller and a prefetch task.
+ */
+class AdaptivePollScheduler {
+    Private std::atomic<ULong> floorMs_;
+    Private std::atomic<ULong> ceilingMs_;
+    Private std::atomic<ULong> intervalMs_;
+    Private std::atomic<ULong> lastPollMs_{0};
+    Private std::atomic<bool> pollNow_{true};
+
+    Public Static constexpr ULong kDefaultFloorMs = 100;
+    /** Stays below PubSubClient's 15 s keepalive, since the MQTT loop only runs when polled. */
+    Public Static constexpr ULong kDefaultCeilingMs = 5000;
+
+    Public AdaptivePollScheduler(ULong floorMs = kDefaultFloorMs, ULong ceilingMs = kDefaultCeilingMs)
+        : floorMs_(floorMs), ceilingMs_(ceilingMs < floorMs ? floorMs : ceilingMs), intervalMs_(floorMs) {}
+
+    /** Sets the backoff bounds and restarts at the floor. */
+    Public Void Configure(ULong floorMs, ULong ceilingMs) {
+        floorMs_.store(floorMs);
+        ceilingMs_.store(ceilingMs < floorMs ? floorMs : ceilingMs);
+        Reset();
+    }
+
+    /** Next ShouldPoll() returns true and the interval restarts at the floor. */
+    Public Void Reset() {
+        intervalMs_.store(floorMs_.load());
+        pollNow_.store(true);
+    }
+
+    Public Bool ShouldPoll(ULong nowMs) const {
+        if (pollNow_.load()) return true;
+        return nowMs - lastPollMs_.load() >= intervalMs_.load();
+    }
+
+    /** Records a completed poll; @p gotData resets the interval to the floor, otherwise it backs off. */
+    Public Void OnPoll(ULong nowMs, Bool gotData) {
+        lastPollMs_.store(nowMs);
+        pollNow_.store(false);
+        if (gotData) {
+            intervalMs_.store(floorMs_.load());
+            return;
+        }
+        ULong next = intervalMs_.load() * 2;
+        ULong ceiling = ceilingMs_.load();
+        intervalMs_.store(next > ceiling ? ceiling : next);
+    }
+
+    Public ULong GetIntervalMs() const {
+        return intervalMs_.load();
+    }
+};
+
+#endif /* ADAPTIVEPOLLSCHEDULER_H */
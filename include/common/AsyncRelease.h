@@ -0,0 +1,26 @@
+#ifndef ASYNCRELEASE_H
+#define ASYNCRELEASE_H
+
+#include <StandardDefines.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <memory>
+
+/**
+ * Drops @p ptr on a short-lived FreeRTOS task so a slow destructor (closing TLS sessions or streams) does not
+ * block the caller. Falls back to releasing inline if the task cannot be created.
+ */
+template <typename T>
+Void ReleaseAsync(std::shared_ptr<T>&& ptr, const Char* taskName, uint32_t stackSize = 4096) {
+    if (!ptr) return;
+    std::shared_ptr<T>* held = new std::shared_ptr<T>(std::move(ptr));
+    auto task = [](Void* arg) {
+        delete static_cast<std::shared_ptr<T>*>(arg);
+        vTaskDelete(nullptr);
+    };
+    if (xTaskCreate(task, taskName, stackSize, held, 1, nullptr) != pdPASS) {
+        delete held;
+    }
+}
+
+#endif /* ASYNCRELEASE_H */
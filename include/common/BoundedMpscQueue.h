@@ -0,0 +1,147 @@
+#ifndef BOUNDEDMPSCQUEUE_H
+#define BOUNDEDMPSCQUEUE_H
+
+#include <StandardDefines.h>
+#include <atomic>
+#include <cstdint>
+
+/** What TryEnqueue does when the queue is full. */
+enum class QueueOverflowPolicy : UInt8 {
+    /** The new item is refused. */
+    RejectNewest,
+    /** The oldest queued item is discarded to make room. */
+    DropOldest
+};
+
+/** Occupancy counters of a BoundedMpscQueue. */
+struct QueueStats {
+    Size capacity;
+    Size size;
+    Size highWaterMark;
+    ULong dropped;
+};
+
+/**
+ * Fixed-capacity lock-free queue of movable items (Vyukov bounded queue: one sequence number per cell,
+ * CAS on the enqueue/dequeue cursors). Built for many producers and one consumer; the algorithm is also
+ * safe for concurrent dequeuers, which DropOldest relies on when producers evict the head.
+ * Capacity must be a power of two. Items are moved in and out; nothing is allocated after construction.
+ */
+template <typename T, Size Capacity>
+class BoundedMpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    Private struct Cell {
+        std::atomic<Size> sequence;
+        T value;
+    };
+
+    Private Static constexpr Size kMask = Capacity - 1;
+
+    Private Cell cells_[Capacity];
+    Private std::atomic<Size> enqueuePos_{0};
+    Private std::atomic<Size> dequeuePos_{0};
+    Private std::atomic<Size> highWaterMark_{0};
+    Private std::atomic<ULong> dropped_{0};
+    Private QueueOverflowPolicy policy_;
+
+    Private Bool TryPush(T& item) {
+        Size pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & kMask];
+            Size seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(item);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    RecordDepth(pos + 1);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Private Void RecordDepth(Size enqueuedEnd) {
+        Size depth = enqueuedEnd - dequeuePos_.load(std::memory_order_relaxed);
+        Size seen = highWaterMark_.load(std::memory_order_relaxed);
+        while (depth > seen && depth <= Capacity &&
+               !highWaterMark_.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    Public Explicit BoundedMpscQueue(QueueOverflowPolicy policy = QueueOverflowPolicy::RejectNewest) : policy_(policy) {
+        for (Size i = 0; i < Capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    /**
+     * Moves @p item into the queue. When full, applies the overflow policy; returns false only if the item
+     * was not queued. Every item lost to overflow (refused or evicted) is counted in QueueStats::dropped.
+     */
+    Public Bool TryEnqueue(T&& item) {
+        if (TryPush(item)) return true;
+        if (policy_ == QueueOverflowPolicy::DropOldest) {
+            T evicted;
+            for (Size attempt = 0; attempt < Capacity; ++attempt) {
+                if (TryDequeue(evicted)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (TryPush(item)) return true;
+            }
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /** Moves the oldest item into @p out. Returns false if the queue is empty. */
+    Public Bool TryDequeue(T& out) {
+        Size pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & kMask];
+            Size seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.value = T();
+                    cell.sequence.store(pos + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Discards all queued items (not counted as dropped). */
+    Public Void Clear() {
+        T discarded;
+        while (TryDequeue(discarded)) {
+        }
+    }
+
+    /** Approximate number of queued items. */
+    Public Size SizeApprox() const {
+        Size enq = enqueuePos_.load(std::memory_order_relaxed);
+        Size deq = dequeuePos_.load(std::memory_order_relaxed);
+        return enq >= deq ? enq - deq : 0;
+    }
+
+    Public QueueStats GetStats() const {
+        return QueueStats{Capacity, SizeApprox(), highWaterMark_.load(std::memory_order_relaxed),
+                          dropped_.load(std::memory_order_relaxed)};
+    }
+};
+
+#endif /* BOUNDEDMPSCQUEUE_H */
@@ -0,0 +1,131 @@
+#ifndef CIRCUITBREAKER_H
+#define CIRCUITBREAKER_H
+
+#include <StandardDefines.h>
+#include <mutex>
+
+enum class CircuitState : UInt8 { Closed, Open, HalfOpen };
+
+struct CircuitBreakerStats {
+    CircuitState state;
+    ULong successes;
+    ULong failures;
+    /** Calls refused while open or while the half-open probe was outstanding. */
+    ULong rejected;
+    /** Closed/half-open to open transitions. */
+    ULong trips;
+    ULong consecutiveFailures;
+    /** Current open period; doubles on every failed probe up to the configured maximum. */
+    ULong cooldownMs;
+    /** Exponentially weighted (1/8) failure rate in per mille and latency in ms over recorded calls. */
+    ULong errorRatePermille;
+    ULong averageLatencyMs;
+};
+
+/**
+ * Closed: calls pass; @p failureThreshold consecutive failures open the circuit.
+ * Open: calls are refused for the cooldown. HalfOpen: a single probe is let through; success closes the
+ * circuit and restores the base cooldown, failure reopens it with the cooldown doubled.
+ * Every TryAcquire() that returns true must be followed by RecordSuccess() or RecordFailure().
+ * Times are millis() values; wrap-around safe. Thread-safe.
+ */
+class CircuitBreaker {
+    Private mutable std::mutex mutex_;
+    Private UInt failureThreshold_;
+    Private ULong baseCooldownMs_;
+    Private ULong maxCooldownMs_;
+
+    Private CircuitState state_ = CircuitState::Closed;
+    Private ULong openedAtMs_ = 0;
+    Private ULong cooldownMs_;
+    Private ULong successes_ = 0;
+    Private ULong failures_ = 0;
+    Private ULong rejected_ = 0;
+    Private ULong trips_ = 0;
+    Private ULong consecutiveFailures_ = 0;
+    Private ULong errorRatePermille_ = 0;
+    Private ULong averageLatencyMs_ = 0;
+
+    Private Void UpdateAverages(Bool failed, ULong latencyMs) {
+        errorRatePermille_ = (errorRatePermille_ * 7 + (failed ? 1000 : 0)) / 8;
+        averageLatencyMs_ = (averageLatencyMs_ * 7 + latencyMs) / 8;
+    }
+
+    Private Void OpenLocked(ULong nowMs) {
+        state_ = CircuitState::Open;
+        openedAtMs_ = nowMs;
+        ++trips_;
+    }
+
+    Public Explicit CircuitBreaker(UInt failureThreshold = 3, ULong baseCooldownMs = 5000, ULong maxCooldownMs = 120000)
+        : failureThreshold_(failureThreshold == 0 ? 1 : failureThreshold),
+          baseCooldownMs_(baseCooldownMs),
+          maxCooldownMs_(maxCooldownMs < baseCooldownMs ? baseCooldownMs : maxCooldownMs),
+          cooldownMs_(baseCooldownMs) {}
+
+    /** Returns true if a call may go ahead now. Moves Open to HalfOpen once the cooldown has elapsed. */
+    Public Bool TryAcquire(ULong nowMs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == CircuitState::Closed) return true;
+        if (state_ == CircuitState::Open && nowMs - openedAtMs_ >= cooldownMs_) {
+            state_ = CircuitState::HalfOpen;
+            return true;
+        }
+        ++rejected_;
+        return false;
+    }
+
+    Public Void RecordSuccess(ULong latencyMs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++successes_;
+        consecutiveFailures_ = 0;
+        UpdateAverages(false, latencyMs);
+        if (state_ == CircuitState::HalfOpen) {
+            state_ = CircuitState::Closed;
+            cooldownMs_ = baseCooldownMs_;
+        }
+    }
+
+    Public Void RecordFailure(ULong nowMs, ULong latencyMs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++failures_;
+        ++consecutiveFailures_;
+        UpdateAverages(true, latencyMs);
+        if (state_ == CircuitState::HalfOpen) {
+            cooldownMs_ = cooldownMs_ > maxCooldownMs_ / 2 ? maxCooldownMs_ : cooldownMs_ * 2;
+            OpenLocked(nowMs);
+        } else if (state_ == CircuitState::Closed && consecutiveFailures_ >= failureThreshold_) {
+            OpenLocked(nowMs);
+        }
+    }
+
+    /** Opens the circuit immediately, e.g. for failures that retrying cannot fix soon (revoked credentials). */
+    Public Void Trip(ULong nowMs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != CircuitState::Open) OpenLocked(nowMs);
+        else openedAtMs_ = nowMs;
+    }
+
+    /** Back to Closed with the base cooldown; statistics are kept. */
+    Public Void Reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_ = CircuitState::Closed;
+        cooldownMs_ = baseCooldownMs_;
+        consecutiveFailures_ = 0;
+    }
+
+    /** True while calls would be refused: open with cooldown remaining, or half-open with the probe outstanding. */
+    Public Bool IsOpen(ULong nowMs) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == CircuitState::HalfOpen) return true;
+        return state_ == CircuitState::Open && nowMs - openedAtMs_ < cooldownMs_;
+    }
+
+    Public CircuitBreakerStats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return CircuitBreakerStats{state_, successes_, failures_, rejected_, trips_, consecutiveFailures_,
+                                   cooldownMs_, errorRatePermille_, averageLatencyMs_};
+    }
+};
+
+#endif /* CIRCUITBREAKER_H */
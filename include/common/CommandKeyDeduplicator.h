@@ -0,0 +1,138 @@
+#ifndef COMMANDKEYDEDUPLICATOR_H
+#define COMMANDKEYDEDUPLICATOR_H
+
+#include <StandardDefines.h>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Fixed-memory set of recently seen command keys.
+ * Keys are stored as FNV-1a fingerprints in an insertion-order ring of @p Capacity slots, indexed by an
+ * open-addressing (linear probing) table. Slots freed by Erase are reused first; only once all Capacity slots
+ * hold live keys does inserting evict the oldest key.
+ * False-positive budget: with n keys held, a new key is wrongly reported as seen with probability about
+ * n / 2^bits(Fingerprint). For 256 keys that is ~1.4e-17 with uint64_t and ~6e-8 with uint32_t.
+ * Not thread-safe; the owner serialises access.
+ */
+template <Size Capacity, typename Fingerprint = uint64_t>
+class CommandKeyDeduplicator {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(Capacity < 0x8000, "ring indices are 16-bit");
+    static_assert(std::is_unsigned<Fingerprint>::value && sizeof(Fingerprint) >= 4, "Fingerprint must be an unsigned type of at least 32 bits");
+
+    Private Static constexpr Size kTableSize = Capacity * 2;
+    Private Static constexpr Size kTableMask = kTableSize - 1;
+    Private Static constexpr uint16_t kEmpty = 0xFFFF;
+
+    /** Fingerprints in insertion order; 0 marks a free or erased slot. */
+    Private Fingerprint ring_[Capacity];
+    /** Ring index per table slot, kEmpty when free. */
+    Private uint16_t table_[kTableSize];
+    Private Size head_ = 0;
+    Private Size size_ = 0;
+
+    Private Static Fingerprint Hash(const Char* data, Size len) {
+        uint64_t h = 14695981039346656037ULL;
+        for (Size i = 0; i < len; ++i) {
+            h ^= static_cast<UInt8>(data[i]);
+            h *= 1099511628211ULL;
+        }
+        if (sizeof(Fingerprint) < sizeof(uint64_t)) {
+            h ^= h >> 32;
+        }
+        Fingerprint fp = static_cast<Fingerprint>(h);
+        return fp == 0 ? 1 : fp;
+    }
+
+    Private Static Size Home(Fingerprint fp) {
+        return static_cast<Size>(fp) & kTableMask;
+    }
+
+    /** Table slot holding @p fp, or kTableSize if absent. */
+    Private Size Find(Fingerprint fp) const {
+        for (Size i = Home(fp);; i = (i + 1) & kTableMask) {
+            if (table_[i] == kEmpty) return kTableSize;
+            if (ring_[table_[i]] == fp) return i;
+        }
+    }
+
+    /** Frees table slot @p i, shifting later entries of the probe run back so lookups never stop early. */
+    Private Void RemoveSlot(Size i) {
+        for (Size j = (i + 1) & kTableMask; table_[j] != kEmpty; j = (j + 1) & kTableMask) {
+            Size k = Home(ring_[table_[j]]);
+            Bool homeInGap = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!homeInGap) {
+                table_[i] = table_[j];
+                i = j;
+            }
+        }
+        table_[i] = kEmpty;
+        --size_;
+    }
+
+    Private Void Place(Size ringIndex) {
+        Size i = Home(ring_[ringIndex]);
+        while (table_[i] != kEmpty) i = (i + 1) & kTableMask;
+        table_[i] = static_cast<uint16_t>(ringIndex);
+    }
+
+    /** Moves the live keys, oldest first, to the front of the ring and points head_ past them. Rebuilds the table. */
+    Private Void Compact() {
+        std::rotate(ring_, ring_ + head_, ring_ + Capacity);
+        Size live = 0;
+        for (Size i = 0; i < Capacity; ++i) {
+            if (ring_[i] != 0) ring_[live++] = ring_[i];
+        }
+        for (Size i = live; i < Capacity; ++i) ring_[i] = 0;
+        for (Size i = 0; i < kTableSize; ++i) table_[i] = kEmpty;
+        for (Size i = 0; i < live; ++i) Place(i);
+        head_ = live & (Capacity - 1);
+    }
+
+    Public CommandKeyDeduplicator() {
+        Clear();
+    }
+
+    Public Void Clear() {
+        for (Size i = 0; i < Capacity; ++i) ring_[i] = 0;
+        for (Size i = 0; i < kTableSize; ++i) table_[i] = kEmpty;
+        head_ = 0;
+        size_ = 0;
+    }
+
+    Public Size Count() const { return size_; }
+
+    Public Bool Contains(CStdString key) const {
+        return Find(Hash(key.data(), key.size())) != kTableSize;
+    }
+
+    /** Records @p key. Returns false if it was already present (a duplicate), true if newly added. */
+    Public Bool Insert(CStdString key) {
+        Fingerprint fp = Hash(key.data(), key.size());
+        if (Find(fp) != kTableSize) return false;
+        if (ring_[head_] != 0 && size_ < Capacity) {
+            // The oldest slot is live but erased slots exist elsewhere; close the gaps instead of evicting.
+            Compact();
+        }
+        if (ring_[head_] != 0) {
+            RemoveSlot(Find(ring_[head_]));
+        }
+        ring_[head_] = fp;
+        Place(head_);
+        head_ = (head_ + 1) & (Capacity - 1);
+        ++size_;
+        return true;
+    }
+
+    /** Forgets @p key, e.g. once its source can no longer redeliver it. Returns false if it was not present. */
+    Public Bool Erase(CStdString key) {
+        Size i = Find(Hash(key.data(), key.size()));
+        if (i == kTableSize) return false;
+        ring_[table_[i]] = 0;
+        RemoveSlot(i);
+        return true;
+    }
+};
+
+#endif /* COMMANDKEYDEDUPLICATOR_H */
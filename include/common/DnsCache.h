@@ -0,0 +1,224 @@
+#ifndef DNSCACHE_H
+#define DNSCACHE_H
+
+#include <StandardDefines.h>
+#include "IDnsCache.h"
+#include "IDnsResolver.h"
+#include <cstring>
+#include <mutex>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * Caches resolver answers for their TTL. Entries in the last quarter of their TTL are refreshed in the
+ * background while the cached address keeps being served; once expired, the last known address is still
+ * served for kStaleGraceMs if the resolver fails, so a DNS outage does not block reconnecting to a recently
+ * known broker. Failed lookups with no usable address are cached for kNegativeTtlMs. Thread-safe; the
+ * resolver is never called with the lock held.
+ */
+/* @Component */
+class DnsCache : public IDnsCache {
+    Private Static const Size kMaxEntries = 8;
+    Private Static const ULong kNegativeTtlMs = 10000;
+    Private Static const ULong kStaleGraceMs = 3600000;
+
+    Private struct Entry {
+        StdString host;
+        Bool hasAddress = false;
+        Bool invalidated = false;
+        Bool refreshing = false;
+        uint32_t address = 0;
+        ULong resolvedAtMs = 0;
+        ULong ttlMs = 0;
+        ULong failedAtMs = 0;
+        ULong lastUsedMs = 0;
+    };
+
+    /* @Autowired */
+    Private IDnsResolverPtr resolver_;
+
+    Private mutable std::mutex mutex_;
+    Private StdVector<Entry> entries_;
+    Private DnsCacheStats stats_{0, 0, 0, 0, 0, 0};
+
+    Private Static ULong Now() {
+#ifdef ARDUINO
+        return millis();
+#else
+        return static_cast<ULong>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    Private Entry* Find(const Char* host) {
+        for (Entry& e : entries_) {
+            if (e.host == host) return &e;
+        }
+        return nullptr;
+    }
+
+    /** Finds or adds the entry for @p host, evicting the least recently used one when full. */
+    Private Entry& FindOrAdd(const Char* host, ULong nowMs) {
+        Entry* e = Find(host);
+        if (e != nullptr) return *e;
+        if (entries_.size() >= kMaxEntries) {
+            Entry* oldest = &entries_[0];
+            for (Entry& candidate : entries_) {
+                if (!candidate.refreshing && nowMs - candidate.lastUsedMs > nowMs - oldest->lastUsedMs) oldest = &candidate;
+            }
+            *oldest = Entry();
+            oldest->host = host;
+            return *oldest;
+        }
+        entries_.push_back(Entry());
+        entries_.back().host = host;
+        return entries_.back();
+    }
+
+    Private Static Bool IsUsable(const Entry& e, ULong nowMs) {
+        return e.hasAddress && nowMs - e.resolvedAtMs < e.ttlMs + kStaleGraceMs;
+    }
+
+    Private Void Store(Entry& e, uint32_t address, ULong ttlMs, ULong nowMs) {
+        e.hasAddress = true;
+        e.invalidated = false;
+        e.address = address;
+        e.ttlMs = ttlMs;
+        e.resolvedAtMs = nowMs;
+    }
+
+    /** Called with the lock held; true if the caller should start a refresh of @p e. */
+    Private Static Bool BeginRefresh(Entry& e) {
+        if (e.refreshing) return false;
+        e.refreshing = true;
+        return true;
+    }
+
+    Private Void Refresh(CStdString host, ULong nowMs) {
+        uint32_t address = 0;
+        ULong ttlMs = 0;
+        Bool ok = resolver_ != nullptr && resolver_->Resolve(host.c_str(), address, ttlMs);
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry* e = Find(host.c_str());
+        if (e == nullptr) return;
+        e->refreshing = false;
+        if (ok) {
+            ++stats_.refreshes;
+            Store(*e, address, ttlMs, nowMs);
+        } else {
+            ++stats_.failures;
+        }
+    }
+
+    /** Refreshes @p host off the caller's thread. The cache is a process-lifetime component, so the task may outlive the call. */
+    Private Void ScheduleRefresh(CStdString host, ULong nowMs) {
+#ifdef ARDUINO
+        (void)nowMs;
+        struct Job {
+            DnsCache* cache;
+            StdString host;
+        };
+        Job* job = new Job{this, host};
+        auto task = [](Void* arg) {
+            Job* j = static_cast<Job*>(arg);
+            j->cache->Refresh(j->host, Now());
+            delete j;
+            vTaskDelete(nullptr);
+        };
+        if (xTaskCreate(task, "dns_refresh", 4096, job, 1, nullptr) != pdPASS) {
+            delete job;
+            std::lock_guard<std::mutex> lock(mutex_);
+            Entry* e = Find(host.c_str());
+            if (e != nullptr) e->refreshing = false;
+        }
+#else
+        Refresh(host, nowMs);
+#endif
+    }
+
+    Public DnsCache() = default;
+
+    /** For wiring a resolver by hand, e.g. a stub in tests. */
+    Public Explicit DnsCache(IDnsResolverPtr resolver) : resolver_(resolver) {}
+
+    Public Virtual ~DnsCache() override = default;
+
+    Public Virtual Bool Lookup(const Char* host, uint32_t& address) override {
+        return LookupAt(host, address, Now());
+    }
+
+    /** Lookup() with an explicit clock. */
+    Public Bool LookupAt(const Char* host, uint32_t& address, ULong nowMs) {
+        if (host == nullptr || *host == '\0') return false;
+        Bool served = false;
+        Bool refresh = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Entry* e = Find(host);
+            if (e != nullptr) {
+                e->lastUsedMs = nowMs;
+                ULong age = nowMs - e->resolvedAtMs;
+                if (e->hasAddress && !e->invalidated && age < e->ttlMs) {
+                    ++stats_.hits;
+                    served = true;
+                    refresh = age >= e->ttlMs - e->ttlMs / 4 && BeginRefresh(*e);
+                } else if (!e->hasAddress && nowMs - e->failedAtMs < kNegativeTtlMs) {
+                    ++stats_.negativeHits;
+                    return false;
+                } else if (!e->invalidated && IsUsable(*e, nowMs)) {
+                    ++stats_.staleHits;
+                    served = true;
+                    refresh = BeginRefresh(*e);
+                }
+                if (served) address = e->address;
+            }
+            if (!served) ++stats_.misses;
+        }
+        if (served) {
+            if (refresh) ScheduleRefresh(host, nowMs);
+            return true;
+        }
+
+        uint32_t resolved = 0;
+        ULong ttlMs = 0;
+        Bool ok = resolver_ != nullptr && resolver_->Resolve(host, resolved, ttlMs);
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& e = FindOrAdd(host, nowMs);
+        e.lastUsedMs = nowMs;
+        if (ok) {
+            Store(e, resolved, ttlMs, nowMs);
+            address = resolved;
+            return true;
+        }
+        ++stats_.failures;
+        if (IsUsable(e, nowMs)) {
+            // Resolver is down; keep serving the last known address and retry in the background from now on.
+            e.invalidated = false;
+            ++stats_.staleHits;
+            address = e.address;
+            return true;
+        }
+        e.hasAddress = false;
+        e.failedAtMs = nowMs;
+        return false;
+    }
+
+    Public Virtual Void Invalidate(const Char* host) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry* e = Find(host);
+        if (e != nullptr) e->invalidated = true;
+    }
+
+    Public Virtual DnsCacheStats GetStats() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+};
+
+#endif /* DNSCACHE_H */
@@ -0,0 +1,34 @@
+#ifndef IDNSCACHE_H
+#define IDNSCACHE_H
+
+#include <StandardDefines.h>
+
+struct DnsCacheStats {
+    /** Answers served from a fresh entry. */
+    ULong hits;
+    /** Answers served past their TTL because the resolver was slow to refresh or failing. */
+    ULong staleHits;
+    /** Lookups refused from a cached failure without asking the resolver. */
+    ULong negativeHits;
+    /** Lookups that had to wait for the resolver. */
+    ULong misses;
+    ULong refreshes;
+    ULong failures;
+};
+
+DefineStandardPointers(IDnsCache)
+
+/** Shared host name cache for the MQTT and Firebase connections. */
+class IDnsCache {
+    Public Virtual ~IDnsCache() = default;
+
+    /** Fills @p address (IPAddress's uint32_t form) for @p host. Returns false if no address is known. */
+    Public Virtual Bool Lookup(const Char* host, uint32_t& address) = 0;
+
+    /** Forces the next Lookup() of @p host to ask the resolver, e.g. after connecting to the cached address failed. */
+    Public Virtual Void Invalidate(const Char* host) = 0;
+
+    Public Virtual DnsCacheStats GetStats() const = 0;
+};
+
+#endif /* IDNSCACHE_H */
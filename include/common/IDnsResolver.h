@@ -0,0 +1,19 @@
+#ifndef IDNSRESOLVER_H
+#define IDNSRESOLVER_H
+
+#include <StandardDefines.h>
+
+DefineStandardPointers(IDnsResolver)
+
+/** Blocking host name lookup behind DnsCache; replaceable by a stub for tests. */
+class IDnsResolver {
+    Public Virtual ~IDnsResolver() = default;
+
+    /**
+     * Resolves @p host to an IPv4 address (as IPAddress's uint32_t form) and how long it may be cached.
+     * Returns false if the name could not be resolved.
+     */
+    Public Virtual Bool Resolve(const Char* host, uint32_t& address, ULong& ttlMs) = 0;
+};
+
+#endif /* IDNSRESOLVER_H */
@@ -0,0 +1,226 @@
+#ifndef JSONOBJECTSCANNER_H
+#define JSONOBJECTSCANNER_H
+
+#include <StandardDefines.h>
+#include <cstdint>
+
+enum class JsonValueKind : UInt8 { String, Number, Bool, Null, Object, Array };
+
+/**
+ * One top-level member as views into the scanned buffer. String keys and values exclude the quotes and
+ * are still escaped when the matching flag is set; objects and arrays span their brackets.
+ */
+struct JsonMemberView {
+    const Char* key;
+    Size keyLength;
+    Bool keyEscaped;
+    const Char* value;
+    Size valueLength;
+    Bool valueEscaped;
+    JsonValueKind kind;
+};
+
+/**
+ * Single-pass scanner over a JSON object that reports each top-level member without building a document,
+ * so input size is bounded only by the buffer. Nested values are skipped, not parsed.
+ */
+class JsonObjectScanner {
+    Private Static Bool IsSpace(Char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    Private Static Void SkipSpace(const Char* data, Size len, Size& pos) {
+        while (pos < len && IsSpace(data[pos])) ++pos;
+    }
+
+    /** At an opening quote; leaves @p pos after the closing quote. */
+    Private Static Bool ScanString(const Char* data, Size len, Size& pos, const Char*& start, Size& length, Bool& escaped) {
+        start = data + pos + 1;
+        escaped = false;
+        for (Size i = pos + 1; i < len; ++i) {
+            if (data[i] == '\\') {
+                escaped = true;
+                ++i;
+            } else if (data[i] == '"') {
+                length = static_cast<Size>(data + i - start);
+                pos = i + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** At '{' or '['; leaves @p pos after the matching bracket. */
+    Private Static Bool SkipContainer(const Char* data, Size len, Size& pos) {
+        Size depth = 0;
+        for (; pos < len; ++pos) {
+            Char c = data[pos];
+            if (c == '"') {
+                const Char* s;
+                Size l;
+                Bool e;
+                if (!ScanString(data, len, pos, s, l, e)) return false;
+                --pos;
+            } else if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    ++pos;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    Private Static Bool MatchLiteral(const Char* data, Size len, Size& pos, const Char* literal, Size literalLen) {
+        if (len - pos < literalLen) return false;
+        for (Size i = 0; i < literalLen; ++i) {
+            if (data[pos + i] != literal[i]) return false;
+        }
+        pos += literalLen;
+        return true;
+    }
+
+    Private Static Bool ScanValue(const Char* data, Size len, Size& pos, JsonMemberView& m) {
+        if (pos >= len) return false;
+        Char c = data[pos];
+        Size begin = pos;
+        if (c == '"') {
+            m.kind = JsonValueKind::String;
+            return ScanString(data, len, pos, m.value, m.valueLength, m.valueEscaped);
+        }
+        m.valueEscaped = false;
+        if (c == '{' || c == '[') {
+            m.kind = c == '{' ? JsonValueKind::Object : JsonValueKind::Array;
+            if (!SkipContainer(data, len, pos)) return false;
+        } else if (c == 't' || c == 'f') {
+            m.kind = JsonValueKind::Bool;
+            if (!MatchLiteral(data, len, pos, c == 't' ? "true" : "false", c == 't' ? 4 : 5)) return false;
+        } else if (c == 'n') {
+            m.kind = JsonValueKind::Null;
+            if (!MatchLiteral(data, len, pos, "null", 4)) return false;
+        } else {
+            m.kind = JsonValueKind::Number;
+            while (pos < len && ((data[pos] >= '0' && data[pos] <= '9') || data[pos] == '-' || data[pos] == '+'
+                                 || data[pos] == '.' || data[pos] == 'e' || data[pos] == 'E')) {
+                ++pos;
+            }
+            if (pos == begin) return false;
+        }
+        m.value = data + begin;
+        m.valueLength = pos - begin;
+        return true;
+    }
+
+    Private Static Void AppendUtf8(uint32_t cp, StdString& out) {
+        if (cp < 0x80) {
+            out += static_cast<Char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<Char>(0xC0 | (cp >> 6));
+            out += static_cast<Char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<Char>(0xE0 | (cp >> 12));
+            out += static_cast<Char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<Char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<Char>(0xF0 | (cp >> 18));
+            out += static_cast<Char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<Char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<Char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    Private Static Bool ReadHex4(const Char* s, Size len, Size i, uint32_t& out) {
+        if (len - i < 4) return false;
+        out = 0;
+        for (Size k = 0; k < 4; ++k) {
+            Char c = s[i + k];
+            out <<= 4;
+            if (c >= '0' && c <= '9') out |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') out |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') out |= static_cast<uint32_t>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    /**
+     * Calls @p onMember(const JsonMemberView&) for each member of the object in @p data, in order; the
+     * callback returns false to stop early. Returns false if the input is not a well-formed object.
+     */
+    Public template <typename OnMember>
+    Static Bool Scan(const Char* data, Size len, OnMember onMember) {
+        Size pos = 0;
+        SkipSpace(data, len, pos);
+        if (pos >= len || data[pos] != '{') return false;
+        ++pos;
+        SkipSpace(data, len, pos);
+        if (pos < len && data[pos] == '}') return true;
+        for (;;) {
+            JsonMemberView m;
+            SkipSpace(data, len, pos);
+            if (pos >= len || data[pos] != '"') return false;
+            if (!ScanString(data, len, pos, m.key, m.keyLength, m.keyEscaped)) return false;
+            SkipSpace(data, len, pos);
+            if (pos >= len || data[pos] != ':') return false;
+            ++pos;
+            SkipSpace(data, len, pos);
+            if (!ScanValue(data, len, pos, m)) return false;
+            if (!onMember(static_cast<const JsonMemberView&>(m))) return true;
+            SkipSpace(data, len, pos);
+            if (pos >= len) return false;
+            if (data[pos] == '}') return true;
+            if (data[pos] != ',') return false;
+            ++pos;
+        }
+    }
+
+    /** Appends the unescaped form of a string view from Scan() to @p out. Returns false on a bad escape. */
+    Public Static Bool Unescape(const Char* s, Size len, StdString& out) {
+        out.reserve(out.size() + len);
+        for (Size i = 0; i < len; ++i) {
+            if (s[i] != '\\') {
+                out += s[i];
+                continue;
+            }
+            if (++i >= len) return false;
+            switch (s[i]) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!ReadHex4(s, len, i + 1, cp)) return false;
+                    i += 4;
+                    uint32_t low;
+                    if (cp >= 0xD800 && cp <= 0xDBFF && len - i > 6 && s[i + 1] == '\\' && s[i + 2] == 'u'
+                        && ReadHex4(s, len, i + 3, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                    AppendUtf8(cp, out);
+                    break;
+                }
+                default: return false;
+            }
+        }
+        return true;
+    }
+
+    /** Appends a string view, unescaping only when needed. */
+    Public Static Bool AppendString(const Char* s, Size len, Bool escaped, StdString& out) {
+        if (!escaped) {
+            out.append(s, len);
+            return true;
+        }
+        return Unescape(s, len, out);
+    }
+};
+
+#endif /* JSONOBJECTSCANNER_H */
@@ -0,0 +1,60 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <StandardDefines.h>
+#include <atomic>
+
+/**
+ * Fixed-capacity lock-free ring for exactly one producer and one consumer thread. Each side owns one
+ * cursor and only reads the other's, so a push or pop is one acquire load and one release store.
+ * Capacity must be a power of two. Items are moved in and out; nothing is allocated after construction.
+ */
+template <typename T, Size Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    Private Static constexpr Size kMask = Capacity - 1;
+
+    Private T slots_[Capacity];
+    /** Next slot to pop; written by the consumer only. */
+    Private std::atomic<Size> head_{0};
+    /** Next slot to fill; written by the producer only. */
+    Private std::atomic<Size> tail_{0};
+
+    Public SpscRing() = default;
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /** Producer side. Moves @p item in; returns false (leaving it untouched) if the ring is full. */
+    Public Bool TryPush(T&& item) {
+        Size tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= Capacity) return false;
+        slots_[tail & kMask] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer side. Moves the oldest item into @p out; returns false if the ring is empty. */
+    Public Bool TryPop(T& out) {
+        Size head = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) == head) return false;
+        out = std::move(slots_[head & kMask]);
+        slots_[head & kMask] = T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Producer side: true if TryPush would fail. */
+    Public Bool IsFull() const {
+        return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) >= Capacity;
+    }
+
+    /** Approximate number of queued items. */
+    Public Size SizeApprox() const {
+        Size head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+};
+
+#endif /* SPSCRING_H */
@@ -0,0 +1,70 @@
+#ifndef TIMESTAMPFORMATTER_H
+#define TIMESTAMPFORMATTER_H
+
+#include <StandardDefines.h>
+#include <cstring>
+#include <ctime>
+
+/**
+ * Formats log timestamps into caller buffers without allocating. The local-time "YYYY-MM-DDTHH:MM:SS" prefix
+ * is cached per second, so a batch of entries within one second costs one localtime_r/strftime and
+ * otherwise only the millisecond suffix is written. Not thread-safe; use one instance per publisher.
+ */
+class TimestampFormatter {
+    Private time_t cachedSecond_ = 0;
+    Private Bool cacheValid_ = false;
+    Private Char prefix_[24];
+    Private Size prefixLength_ = 0;
+
+    /** Fits "YYYY-MM-DDTHH:MM:SS_mmm" and any 64-bit decimal value with a short tag. */
+    Public Static const Size kBufferSize = 40;
+
+    /** Drops the cached prefix, e.g. after the time zone changes. */
+    Public Void Invalidate() {
+        cacheValid_ = false;
+    }
+
+    /**
+     * Writes the local time of @p epochMs as "YYYY-MM-DDTHH:MM:SS_mmm" plus a terminator into @p out.
+     * Returns the length, or 0 if the time cannot be converted or @p size is too small.
+     */
+    Public Size FormatLocal(ULongLong epochMs, Char* out, Size size) {
+        time_t sec = static_cast<time_t>(epochMs / 1000);
+        if (!cacheValid_ || sec != cachedSecond_) {
+            struct tm t;
+            if (!localtime_r(&sec, &t)) return 0;
+            prefixLength_ = strftime(prefix_, sizeof(prefix_), "%Y-%m-%dT%H:%M:%S", &t);
+            if (prefixLength_ == 0) return 0;
+            cachedSecond_ = sec;
+            cacheValid_ = true;
+        }
+        if (size < prefixLength_ + 5) return 0;
+        UInt ms = static_cast<UInt>(epochMs % 1000);
+        memcpy(out, prefix_, prefixLength_);
+        Char* p = out + prefixLength_;
+        p[0] = '_';
+        p[1] = static_cast<Char>('0' + ms / 100);
+        p[2] = static_cast<Char>('0' + (ms / 10) % 10);
+        p[3] = static_cast<Char>('0' + ms % 10);
+        p[4] = '\0';
+        return prefixLength_ + 4;
+    }
+
+    /** Writes @p value in decimal plus a terminator into @p out. Returns the length, or 0 if @p size is too small. */
+    Public Static Size FormatDecimal(ULongLong value, Char* out, Size size) {
+        Char digits[20];
+        Size n = 0;
+        do {
+            digits[n++] = static_cast<Char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        if (size < n + 1) return 0;
+        for (Size i = 0; i < n; ++i) {
+            out[i] = digits[n - 1 - i];
+        }
+        out[n] = '\0';
+        return n;
+    }
+};
+
+#endif /* TIMESTAMPFORMATTER_H */
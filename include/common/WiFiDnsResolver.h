@@ -0,0 +1,30 @@
+#ifdef ARDUINO
+#ifndef WIFIDNSRESOLVER_H
+#define WIFIDNSRESOLVER_H
+
+#include "IDnsResolver.h"
+#include <WiFi.h>
+
+/**
+ * Resolves through the station's DNS servers. WiFi.hostByName does not report the record TTL, so every
+ * answer is cached for kTtlMs.
+ */
+/* @Component */
+class WiFiDnsResolver : public IDnsResolver {
+    Private Static const ULong kTtlMs = 300000;
+
+    Public WiFiDnsResolver() = default;
+    Public Virtual ~WiFiDnsResolver() override = default;
+
+    Public Virtual Bool Resolve(const Char* host, uint32_t& address, ULong& ttlMs) override {
+        if (WiFi.status() != WL_CONNECTED) return false;
+        IPAddress ip;
+        if (!WiFi.hostByName(host, ip)) return false;
+        address = static_cast<uint32_t>(ip);
+        ttlMs = kTtlMs;
+        return address != 0;
+    }
+};
+
+#endif // WIFIDNSRESOLVER_H
+#endif // ARDUINO
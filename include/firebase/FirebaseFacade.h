@@ -8,15 +8,20 @@
 #include <ILogger.h>
 #include <INetworkStatusProvider.h>
 #include <Arduino.h>
+#include "../common/BoundedMpscQueue.h"
+#include "../common/AdaptivePollScheduler.h"
+#include "../common/AsyncRelease.h"
 
-#include <queue>
+#include <atomic>
 #include <mutex>
 
 /* @Component */
 /* @Scope("PROTOTYPE") */
 class FirebaseFacade : public IFirebaseFacade {
 
+    /** Published with std::atomic_store and read with std::atomic_load, so the hot paths never take firebaseOperationsMutex_. */
     Private IFirebaseOperationsPtr firebaseOperations;
+    /** Serialises Reset/Stop/Start (the writers) and guards parkedOperations_. */
     Private mutable std::mutex firebaseOperationsMutex_;
 
     /* @Autowired */
@@ -25,21 +30,31 @@ class FirebaseFacade : public IFirebaseFacade {
     /* @Autowired */
     Private INetworkStatusProviderPtr networkStatusProvider_;
 
-    Private std::queue<StdString> requestQueue_;
-    Private std::mutex requestQueueMutex_;
+    Private Static constexpr Size kCommandQueueCapacity = 32;
+    /** Pending commands. Polls fetch no more than the free space, so an accepted command is never dropped. */
+    Private BoundedMpscQueue<StdString, kCommandQueueCapacity> requestQueue_{QueueOverflowPolicy::RejectNewest};
+    /** Keeps polls one at a time, so the free space measured before a poll is still free when it is enqueued. */
+    Private std::atomic<bool> pollInProgress_{false};
+
+    Private AdaptivePollScheduler pollScheduler_;
+    /** Instance set aside by StopFirebaseOperations so StartFirebaseOperations resumes it warm; guarded by firebaseOperationsMutex_. */
+    Private IFirebaseOperationsPtr parkedOperations_;
 
     Private Bool TryDequeue(StdString& out) {
-        std::lock_guard<std::mutex> lock(requestQueueMutex_);
-        if (requestQueue_.empty()) return false;
-        out = requestQueue_.front();
-        requestQueue_.pop();
-        return true;
+        return requestQueue_.TryDequeue(out);
+    }
+
+    /** Free queue slots; only the poller adds items, so the value can only grow until it enqueues. */
+    Private Size QueueRoom() const {
+        Size size = requestQueue_.SizeApprox();
+        return size >= kCommandQueueCapacity ? 0 : kCommandQueueCapacity - size;
     }
 
-    Private Void EnqueueAll(const StdVector<StdString>& commands) {
-        std::lock_guard<std::mutex> lock(requestQueueMutex_);
-        for (const StdString& s : commands) {
-            requestQueue_.push(s);
+    Private Void EnqueueAll(StdVector<StdString>& commands) {
+        for (StdString& s : commands) {
+            if (!requestQueue_.TryEnqueue(std::move(s))) {
+                logger->Error(Tag::Untagged, StdString("[FirebaseFacade] Command queue full, command not queued"));
+            }
         }
     }
 
@@ -47,38 +62,79 @@ class FirebaseFacade : public IFirebaseFacade {
         ResetFirebaseOperations();
     }
 
-    Public Virtual ~FirebaseFacade() override = default;
+    /** Closing the stream and sessions can take a while, so the last reference is dropped off the caller's thread. */
+    Public Virtual ~FirebaseFacade() override {
+        ReleaseAsync(std::move(firebaseOperations), "fbRelease");
+        ReleaseAsync(std::move(parkedOperations_), "fbRelease");
+    }
+
+    Private IFirebaseOperationsPtr CurrentOperations() const {
+        return std::atomic_load(&firebaseOperations);
+    }
+
+    /** Call with firebaseOperationsMutex_ held. Makes the parked instance (or a new one) current if there is none. */
+    Private Void EnsureOperations() {
+        if (firebaseOperations) return;
+        if (parkedOperations_) {
+            std::atomic_store(&firebaseOperations, std::move(parkedOperations_));
+            parkedOperations_ = nullptr;
+        } else {
+            std::atomic_store(&firebaseOperations, IFirebaseOperationsPtr(std::make_shared<FirebaseOperations>()));
+        }
+    }
 
-    /** Thread-safe: replaces firebaseOperations with a new FirebaseOperations instance. Proceeds only if internet is available. */
+    /** Thread-safe soft reset: clears the error state of the current (or parked) instance and the command queue,
+     *  keeping its connections, stream and dedup state. Creates an instance only if there is none. */
     Public Void ResetFirebaseOperations() override {
         logger->Info(Tag::Untagged, StdString("[FirebaseFacade] Resetting Firebase operations."));
         std::lock_guard<std::mutex> lock(firebaseOperationsMutex_);
-        firebaseOperations = std::make_shared<FirebaseOperations>();
+        EnsureOperations();
+        firebaseOperations->SoftReset();
+        requestQueue_.Clear();
+        pollScheduler_.Reset();
     }
 
+    /** Parks the instance; nothing is torn down, so a later Start resumes immediately. */
     Public Void StopFirebaseOperations() override {
         logger->Info(Tag::Untagged, StdString("[FirebaseFacade] Stopping Firebase operations."));
         std::lock_guard<std::mutex> lock(firebaseOperationsMutex_);
-        firebaseOperations = nullptr;
+        if (firebaseOperations) {
+            parkedOperations_ = std::atomic_exchange(&firebaseOperations, IFirebaseOperationsPtr());
+        }
     }
 
     Public Void StartFirebaseOperations() override {
         logger->Info(Tag::Untagged, StdString("[FirebaseFacade] Starting Firebase operations."));
         std::lock_guard<std::mutex> lock(firebaseOperationsMutex_);
-        firebaseOperations = std::make_shared<FirebaseOperations>();
+        EnsureOperations();
     }
 
-    Public Bool IsDirty() const override {
+    Public Void SetPollInterval(ULong floorMs, ULong ceilingMs) override {
+        pollScheduler_.Configure(floorMs, ceilingMs);
+    }
+
+    Public QueueStats GetCommandQueueStats() const override {
+        return requestQueue_.GetStats();
+    }
+
+    Public FirebaseReadStats GetReadStats() const override {
         std::lock_guard<std::mutex> lock(firebaseOperationsMutex_);
-        return firebaseOperations ? firebaseOperations->IsDirty() : false;
+        IFirebaseOperationsPtr ops = firebaseOperations ? firebaseOperations : parkedOperations_;
+        return ops ? ops->GetReadStats() : FirebaseReadStats{0, 0, 0, 0};
+    }
+
+    Public CircuitBreakerStats GetCircuitStats() const override {
+        IFirebaseOperationsPtr ops = CurrentOperations();
+        return ops ? ops->GetCircuitStats() : CircuitBreakerStats{CircuitState::Closed, 0, 0, 0, 0, 0, 0, 0, 0};
+    }
+
+    Public Bool IsDirty() const override {
+        IFirebaseOperationsPtr ops = CurrentOperations();
+        return ops ? ops->IsDirty() : false;
     }
 
     Public FirebaseOperationResult PublishLogs(const StdMap<ULongLong, StdString>& logs) override {
-        IFirebaseOperationsPtr ops;
-        {
-            std::lock_guard<std::mutex> lock(firebaseOperationsMutex_);
-            ops = firebaseOperations;
-        }
+        IFirebaseOperationsPtr ops = CurrentOperations();
         if (!ops) return FirebaseOperationResult::NotReady;
         if (ops->IsDirty()) return FirebaseOperationResult::NotReady;
         if (ops->IsOperationInProgress()) return FirebaseOperationResult::AnotherOperationInProgress;
@@ -90,19 +146,30 @@ class FirebaseFacade : public IFirebaseFacade {
         if (TryDequeue(out)) {
             return FirebaseOperationResult::OperationSucceeded;
         }
-        IFirebaseOperationsPtr ops;
-        {
-            std::lock_guard<std::mutex> lock(firebaseOperationsMutex_);
-            ops = firebaseOperations;
-        }
+        IFirebaseOperationsPtr ops = CurrentOperations();
         if (!ops) return FirebaseOperationResult::NotReady;
         if (ops->IsDirty()) {
             if (ops->IsOperationInProgress()) return FirebaseOperationResult::AnotherOperationInProgress;
             return FirebaseOperationResult::NotReady;
         }
+        if (!pollScheduler_.ShouldPoll(millis())) {
+            return FirebaseOperationResult::OperationSucceeded;
+        }
+        if (pollInProgress_.exchange(true)) {
+            return FirebaseOperationResult::AnotherOperationInProgress;
+        }
+        struct ClearPoll {
+            std::atomic<bool>& f;
+            ~ClearPoll() { f.store(false); }
+        } pollGuard{pollInProgress_};
+        Size room = QueueRoom();
+        if (room == 0) {
+            return FirebaseOperationResult::OperationSucceeded;
+        }
         StdVector<StdString> commands;
-        FirebaseOperationResult res = ops->RetrieveCommands(commands);
+        FirebaseOperationResult res = ops->RetrieveCommands(commands, room);
         if (res != FirebaseOperationResult::OperationSucceeded) return res;
+        pollScheduler_.OnPoll(millis(), !commands.empty());
         EnqueueAll(commands);
         if (TryDequeue(out)) {
             return FirebaseOperationResult::OperationSucceeded;
@@ -3,19 +3,36 @@
 #define FIREBASEOPERATIONS_H
 
 #include "IFirebaseOperations.h"
+#include "IFirebaseSessionPool.h"
+#include "../common/CommandKeyDeduplicator.h"
+#include "../common/JsonObjectScanner.h"
+#include "../common/TimestampFormatter.h"
+#include "../common/CircuitBreaker.h"
 #include <ILogger.h>
 #include <IDeviceDetails.h>
 
 #define Vector __FirebaseVector
 #include <Arduino.h>
 #include <Firebase_ESP_Client.h>
-#include <ArduinoJson.h>
+#include <HTTPClient.h>
 #undef Vector
 
 #include <atomic>
 #include <ctime>
-#include <set>
 
+/** Database endpoint and token; override with build flags, e.g. to point at a local RTDB/SSE stand-in. */
+#ifndef FIREBASE_DATABASE_URL
+#define FIREBASE_DATABASE_URL "https://smart-switch-da084-default-rtdb.asia-southeast1.firebasedatabase.app"
+#endif
+#ifndef FIREBASE_LEGACY_TOKEN
+#define FIREBASE_LEGACY_TOKEN "Aj54Sf7eKxCaMIgTgEX4YotS8wbVpzmspnvK6X2C"
+#endif
+
+/**
+ * Commands are read with a GET of the whole commands node per poll by default. Build with
+ * -DFIREBASE_COMMANDS_USE_STREAM to read them from an RTDB SSE stream instead, which only delivers
+ * put/patch deltas; -DFIREBASE_SSE_TIMEOUT_MS sets how long without a keepalive before the stream is resumed.
+ */
 class FirebaseOperations : public IFirebaseOperations {
     /* @Autowired */
     Private ILoggerPtr logger;
@@ -23,24 +40,48 @@ class FirebaseOperations : public IFirebaseOperations {
     Private IDeviceDetailsPtr deviceDetails_;
     Private Int storedWifiConnectionId_{0};
 
+    /* @Autowired */
+    Private IFirebaseSessionPoolPtr sessionPool_;
+
+    /** Only used for the command stream; every other request is plain REST over sessionPool_. */
     Private FirebaseData fbdo;
-    Private FirebaseData fbdoDel;
-    Private FirebaseData fbdoLog;
+    /** Log batches are serialized exactly once, into this reused buffer, and sent as the raw request body. */
+    Private StdString logBody_;
+    Private StdString responseBody_;
+    /** ETag of the last full commands read; unchanged polls are answered 304 and skip parse and dedup. */
+    Private StdString commandsEtag_;
+    Private Size lastCommandsBytes_ = 0;
+    Private ULong lastCommandsParseMicros_ = 0;
+    Private std::atomic<ULong> readPolls_{0};
+    Private std::atomic<ULong> readNotModified_{0};
+    Private std::atomic<ULong> readBytesSaved_{0};
+    Private std::atomic<ULong> readParseMicrosSaved_{0};
     Private FirebaseAuth auth;
     Private FirebaseConfig config;
     Private Bool firebaseBegun = false;
     Private Bool streamBegun_ = false;
     /** Only one of RetrieveCommands or PublishLogs may run at a time. */
     Private std::atomic<bool> operationInProgress_{false};
-    /** When true, all public methods return default/empty without doing work. Set on any error; clear via ResetConnection(). */
-    Private std::atomic<bool> dirty_{false};
+    /** Failed operations open it; while open, public methods return NotReady without touching the network.
+     *  After the cooldown one operation probes, and success closes it again without rebuilding the instance. */
+    Private CircuitBreaker breaker_;
+    /** Set by OnOperationError during the current operation; decides what is recorded on breaker_. */
+    Private Bool operationFailed_ = false;
 
-    Private Static const char* kDatabaseUrl() { return "https://smart-switch-da084-default-rtdb.asia-southeast1.firebasedatabase.app"; }
-    Private Static const char* kLegacyToken() { return "Aj54Sf7eKxCaMIgTgEX4YotS8wbVpzmspnvK6X2C"; }
-    Private Static const unsigned long kDeleteIntervalMs = 60000;
-    Private unsigned long lastDeleteMillis_ = 0;
-    /** Keys we have already processed; duplicate keys are ignored. Cleared when we delete the commands node. */
-    Private std::set<StdString> seenCommandKeys_;
+    Private Static const char* kDatabaseUrl() { return FIREBASE_DATABASE_URL; }
+    Private Static const char* kLegacyToken() { return FIREBASE_LEGACY_TOKEN; }
+    /** Processed keys are deleted from the commands node in one PATCH once the oldest has waited this long... */
+    Private Static const unsigned long kDeleteIntervalMs = 5000;
+    /** ...or as soon as this many are pending. */
+    Private Static const Size kMaxDeleteBatch = 32;
+    Private unsigned long firstPendingDeleteMillis_ = 0;
+    /** Most keys handed out but not yet deleted; while this many are pending, no new commands are handed out. */
+    Private Static const Size kMaxPendingDeletes = 256;
+    /** Keys handed out but not yet deleted from the commands node. */
+    Private StdVector<StdString> pendingDeleteKeys_;
+    /** Keys we have already processed; duplicate keys are ignored. A key is dropped once its node is deleted.
+     *  Only pending keys are held and they are capped at the capacity, so a live key is never evicted. */
+    Private CommandKeyDeduplicator<kMaxPendingDeletes> seenCommandKeys_;
 
     Private StdString GetCommandsPath() const {
         return "/" + deviceDetails_->GetSerialNumber() + "/commands";
@@ -50,6 +91,7 @@ class FirebaseOperations : public IFirebaseOperations {
     }
     /** UTC ms when millis() was 0; set when converting pre-NTP keys (key = millis*1000+seq). ULongLong to avoid 32-bit truncation. */
     Private ULongLong epochOffsetMs_{0};
+    Private TimestampFormatter timestampFormatter_;
 
     Private Void EnsureFirebaseBegin() {
         if (firebaseBegun) return;
@@ -57,10 +99,6 @@ class FirebaseOperations : public IFirebaseOperations {
         config.signer.tokens.legacy_token = kLegacyToken();
         fbdo.setBSSLBufferSize(4096, 1024);
         fbdo.setResponseSize(2048);
-        fbdoDel.setBSSLBufferSize(4096, 1024);
-        fbdoDel.setResponseSize(2048);
-        fbdoLog.setBSSLBufferSize(4096, 1024);
-        fbdoLog.setResponseSize(2048);
         Firebase.begin(&config, &auth);
         Firebase.reconnectWiFi(true);
         firebaseBegun = true;
@@ -77,154 +115,312 @@ class FirebaseOperations : public IFirebaseOperations {
         return true;
     }
 
-    Private Static Void ParseJsonToKeyValuePairs(const StdString& jsonStr, StdList<StdString>& out, StdList<StdString>& outKeys) {
-        DynamicJsonDocument doc(2048);
-        DeserializationError err = deserializeJson(doc, jsonStr);
-        if (err) return;
-        if (!doc.is<JsonObject>()) return;
-        JsonObject root = doc.as<JsonObject>();
-        for (JsonPair p : root) {
-            StdString key(p.key().c_str());
-            outKeys.push_back(key);
-            StdString value;
-            if (p.value().is<const char*>())
-                value = p.value().as<const char*>();
-            else if (p.value().is<int>())
-                value = std::to_string(p.value().as<int>());
-            else if (p.value().is<bool>())
-                value = p.value().as<bool>() ? "true" : "false";
-            else if (p.value().is<double>())
-                value = std::to_string(p.value().as<double>());
-            else {
-                String s;
-                serializeJson(p.value(), s);
-                value = StdString(s.c_str());
-            }
-            out.push_back(key + ":" + value);
+    /** Drops the stream so the next EnsureStreamBegin() resumes it; RTDB then replays the node as one put. */
+    Private Void RestartStream() {
+        if (streamBegun_) {
+            Firebase.RTDB.endStream(&fbdo);
+            streamBegun_ = false;
         }
     }
 
-    Private Void OnErrorAndScheduleRefresh(const char* msg) {
+    Private Void OnOperationError(const char* msg) {
         logger->Error(Tag::Untagged, StdString(std::string("[FirebaseOperations] RetrieveCommands failed: ") + msg));
-        dirty_.store(true);
+        operationFailed_ = true;
     }
 
-
-    /** Returns false if dirty, network/Firebase mismatch, or Firebase not ready. Otherwise ensures Firebase begun and returns true. */
-    Private Bool EnsureReady() {
-        if (dirty_.load(std::memory_order_relaxed)) return false;
+    /** Returns false if the circuit is open or Firebase is not ready. Otherwise ensures Firebase begun and returns true;
+     *  the caller then owes breaker_ an outcome via FinishOperation(). */
+    Private Bool EnsureReady(ULong startMs) {
+        if (!breaker_.TryAcquire(startMs)) return false;
+        operationFailed_ = false;
         EnsureFirebaseBegin();
         if (!Firebase.ready()) {
-            dirty_.store(true);
+            breaker_.RecordFailure(millis(), millis() - startMs);
             return false;
         }
         return true;
     }
 
-    /** Convert key (UTC ms or sec*1000+seq) to Firebase-safe key in local time "2026-02-17T18-30-00_123" (no Z; TZ set by DeviceTimeSyncNtp). When NTP not synced, format as "1970-01-01T00-29-12_041" using value as sec since epoch. */
-    Private StdString MillisToIso8601(ULongLong timestampMs) {
-        auto FormatAsTime = [](ULongLong ms) -> StdString {
-            time_t sec = static_cast<time_t>(ms / 1000);
-            unsigned int subMs = static_cast<unsigned int>(ms % 1000);
-            struct tm* t = localtime(&sec);
-            if (!t) return "millis_" + std::to_string((unsigned long long)ms);
-            char buf[32];
-            if (strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", t) == 0) return "millis_" + std::to_string((unsigned long long)ms);
-            char out[40];
-            snprintf(out, sizeof(out), "%s_%03u", buf, subMs);
-            return StdString(out);
-        };
-        ULongLong utcMs;
-        if (timestampMs >= 1000000000000ULL) {
-            utcMs = timestampMs;
+    Private Void FinishOperation(ULong startMs) {
+        ULong now = millis();
+        if (operationFailed_) {
+            breaker_.RecordFailure(now, now - startMs);
         } else {
+            breaker_.RecordSuccess(now - startMs);
+        }
+    }
+
+    /** Writes the Firebase-safe key for @p timestampMs (UTC ms or millis()-based) into @p out, in local time
+     *  "2026-02-17T18:30:00_123" (no Z; TZ set by DeviceTimeSyncNtp). Before NTP sync, millis()-based values are
+     *  formatted as seconds since the epoch, e.g. "1970-01-01T00:29:12_041". Returns the length. */
+    Private Size FormatLogKey(ULongLong timestampMs, Char* out, Size size) {
+        ULongLong utcMs = timestampMs;
+        if (timestampMs < 1000000000000ULL) {
             if (epochOffsetMs_ == 0) {
                 time_t now = time(nullptr);
                 if (now >= 978307200) {
                     epochOffsetMs_ = (ULongLong)now * 1000ULL - (ULongLong)millis();
-                } else {
-                    return FormatAsTime(timestampMs);
                 }
             }
-            utcMs = epochOffsetMs_ + timestampMs;
+            if (epochOffsetMs_ != 0) {
+                utcMs = epochOffsetMs_ + timestampMs;
+            }
         }
-        time_t sec = static_cast<time_t>(utcMs / 1000);
-        unsigned int ms = static_cast<unsigned int>(utcMs % 1000);
-        struct tm* t = localtime(&sec);
-        if (!t) return FormatAsTime(utcMs);
-        char buf[32];
-        size_t n = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", t);
-        if (n == 0) return FormatAsTime(utcMs);
-        char out[40];
-        snprintf(out, sizeof(out), "%s_%03u", buf, ms);
-        return StdString(out);
+        Size n = timestampFormatter_.FormatLocal(utcMs, out, size);
+        if (n != 0) return n;
+        static const char kFallbackTag[] = "millis_";
+        const Size tagLength = sizeof(kFallbackTag) - 1;
+        memcpy(out, kFallbackTag, tagLength);
+        return tagLength + TimestampFormatter::FormatDecimal(utcMs, out + tagLength, size - tagLength);
     }
 
-    /** Returns all key:value pairs from one read. Uses GET (not stream) so the device
-     *  sees commands regardless of who wrote them. Call only while operationInProgress_ is held. */
-    Private StdVector<StdString> RetrieveCommandsFromFirebase() {
-        StdVector<StdString> emptyResult;
-        EnsureFirebaseBegin();
-        StdString cmdPath = GetCommandsPath();
-
-        if (!Firebase.RTDB.get(&fbdo, cmdPath.c_str())) {
-            OnErrorAndScheduleRefresh(fbdo.errorReason().c_str());
-            return emptyResult;
+    Private Static Void AppendJsonString(StdString& out, const Char* value, Size length) {
+        static const char kHex[] = "0123456789abcdef";
+        out += '"';
+        for (Size i = 0; i < length; ++i) {
+            Char c = value[i];
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<UInt8>(c) < 0x20) {
+                        out += "\\u00";
+                        out += kHex[(c >> 4) & 0x0F];
+                        out += kHex[c & 0x0F];
+                    } else {
+                        out += c;
+                    }
+            }
         }
+        out += '"';
+    }
 
-        if (fbdo.dataType() == "null" || !fbdo.dataAvailable()) {
-            unsigned long now = millis();
-            if (now - lastDeleteMillis_ >= kDeleteIntervalMs) {
-                if (!Firebase.RTDB.deleteNode(&fbdoDel, cmdPath.c_str())) {
-                    OnErrorAndScheduleRefresh(fbdoDel.errorReason().c_str());
-                } else {
-                    lastDeleteMillis_ = now;
-                    seenCommandKeys_.clear();
-                }
+    /** Writes {"<iso key>": "<message>", ...} into @p out, reusing its capacity. A later entry whose key formats
+     *  identically replaces the earlier one, as a JSON object would. Returns false if there is nothing to send. */
+    Private Bool SerializeLogs(const StdMap<ULongLong, StdString>& logs, StdString& out) {
+        out.clear();
+        out += '{';
+        Char keys[2][TimestampFormatter::kBufferSize];
+        Size keyLengths[2] = {0, 0};
+        Size current = 0;
+        Size previousStart = 0;
+        for (const auto& pair : logs) {
+            const StdString& message = pair.second;
+            if (message.empty()) continue;
+            Char* key = keys[current];
+            Size keyLength = keyLengths[current] = FormatLogKey(pair.first, key, sizeof(keys[current]));
+            const Char* previousKey = keys[current ^ 1];
+            if (previousStart != 0 && keyLength == keyLengths[current ^ 1] && memcmp(key, previousKey, keyLength) == 0) {
+                out.resize(previousStart);
+            } else if (out.size() > 1) {
+                out += ',';
             }
-            return emptyResult;
+            previousStart = out.size();
+            AppendJsonString(out, key, keyLength);
+            out += ':';
+            AppendJsonString(out, message.data(), message.size());
+            current ^= 1;
         }
+        if (out.size() == 1) return false;
+        out += '}';
+        return true;
+    }
 
-        String raw = fbdo.to<String>();
-        StdString payload(raw.c_str());
-
-        StdList<StdString> result;
-        StdList<StdString> keysReceived;
-        ParseJsonToKeyValuePairs(payload, result, keysReceived);
+    Private Static StdString RestUrl(CStdString path, const char* query) {
+        StdString url(kDatabaseUrl());
+        url += path;
+        url += ".json?";
+        if (*query) {
+            url += query;
+            url += '&';
+        }
+        url += "auth=";
+        url += kLegacyToken();
+        return url;
+    }
 
-        StdVector<StdString> out;
-        auto keyIt = keysReceived.begin();
-        auto resultIt = result.begin();
-        for (; keyIt != keysReceived.end() && resultIt != result.end(); ++keyIt, ++resultIt) {
-            const StdString& key = *keyIt;
-            if (seenCommandKeys_.find(key) != seenCommandKeys_.end())
-                continue;
-            seenCommandKeys_.insert(key);
-            out.push_back(*resultIt);
+    /** Sends one REST request on a pooled session. Returns true on 2xx; otherwise describes the failure in @p error. */
+    Private Bool SendRest(const char* method, CStdString path, const char* query, const StdString* body, StdString* response, StdString& error) {
+        if (!sessionPool_) {
+            error = "no session pool";
+            return false;
         }
+        Int code = sessionPool_->Send(method, RestUrl(path, query), body, response, nullptr);
+        if (code >= 200 && code < 300) return true;
+        error = DescribeRestError(code);
+        return false;
+    }
+
+    Private Static StdString DescribeRestError(Int code) {
+        return code < 0 ? StdString(HTTPClient::errorToString(code).c_str()) : "HTTP " + std::to_string(code);
+    }
+
+    /** Records unseen @p key as handed out and pending deletion. */
+    Private Void MarkSeen(CStdString key) {
+        seenCommandKeys_.Insert(key);
+        if (pendingDeleteKeys_.empty()) firstPendingDeleteMillis_ = millis();
+        pendingDeleteKeys_.push_back(key);
+    }
 
-        /* unsigned long now = millis();
-        if (now - lastDeleteMillis_ >= kDeleteIntervalMs) {
-            if (!Firebase.RTDB.deleteNode(&fbdoDel, cmdPath.c_str())) {
-                OnErrorAndScheduleRefresh(fbdoDel.errorReason().c_str());
+    /** Appends "key:value" for each unseen member of the commands object in @p json, scanning the buffer once, until
+     *  @p out holds @p max entries. Seen keys are skipped before their value is copied. String values are unescaped;
+     *  other values are kept as raw JSON. Returns true if unseen members were left out for lack of room. */
+    Private Bool AppendUnseenFromJson(const Char* json, Size len, StdVector<StdString>& out, Size max) {
+        StdString key;
+        Bool truncated = false;
+        Bool ok = JsonObjectScanner::Scan(json, len, [&](const JsonMemberView& m) -> Bool {
+            // Null members are deletions (e.g. our own cleanup PATCH echoed on the stream), not commands.
+            if (m.kind == JsonValueKind::Null) return true;
+            key.clear();
+            if (!JsonObjectScanner::AppendString(m.key, m.keyLength, m.keyEscaped, key) || seenCommandKeys_.Contains(key)) return true;
+            if (out.size() >= max) {
+                truncated = true;
+                return true;
+            }
+            MarkSeen(key);
+            StdString pair(key);
+            pair += ':';
+            if (m.kind == JsonValueKind::String) {
+                JsonObjectScanner::AppendString(m.value, m.valueLength, m.valueEscaped, pair);
             } else {
-                lastDeleteMillis_ = now;
-                seenCommandKeys_.clear();
+                pair.append(m.value, m.valueLength);
+            }
+            out.push_back(std::move(pair));
+            return true;
+        });
+        if (!ok) {
+            logger->Error(Tag::Untagged, StdString("[FirebaseOperations] RetrieveCommands: malformed commands payload"));
+        }
+        return truncated;
+    }
+
+    /** Deletes processed keys with one multi-path PATCH of nulls, coalesced by kDeleteIntervalMs / kMaxDeleteBatch.
+     *  Deleted keys leave seenCommandKeys_, which keeps both the node and the set bounded. On failure the keys stay pending. */
+    Private Void FlushPendingDeletes() {
+        if (pendingDeleteKeys_.empty()) return;
+        if (pendingDeleteKeys_.size() < kMaxDeleteBatch && millis() - firstPendingDeleteMillis_ < kDeleteIntervalMs) return;
+        StdString nulls("{");
+        for (const StdString& key : pendingDeleteKeys_) {
+            if (nulls.size() > 1) nulls += ',';
+            AppendJsonString(nulls, key.data(), key.size());
+            nulls += ":null";
+        }
+        nulls += '}';
+        StdString error;
+        if (!SendRest("PATCH", GetCommandsPath(), "print=silent", &nulls, nullptr, error)) {
+            OnOperationError(error.c_str());
+            return;
+        }
+        for (const StdString& key : pendingDeleteKeys_) {
+            seenCommandKeys_.Erase(key);
+        }
+        pendingDeleteKeys_.clear();
+    }
+
+    /** Returns up to @p max key:value pairs delivered by the commands stream since the last call (at most one event
+     *  per call). Call only while operationInProgress_ is held. */
+    Private StdVector<StdString> RetrieveCommandsFromStream(Size max) {
+        StdVector<StdString> out;
+        EnsureFirebaseBegin();
+        if (!EnsureStreamBegin()) {
+            OnOperationError(fbdo.errorReason().c_str());
+            return out;
+        }
+        if (!Firebase.RTDB.readStream(&fbdo)) {
+            OnOperationError((StdString("readStream: ") + fbdo.errorReason().c_str()).c_str());
+            RestartStream();
+            return out;
+        }
+        if (fbdo.streamTimeout()) {
+            // No event or keepalive within FIREBASE_SSE_TIMEOUT_MS; resume on a fresh connection if it dropped.
+            if (!fbdo.httpConnected()) {
+                RestartStream();
+            }
+            return out;
+        }
+        if (!fbdo.streamAvailable()) {
+            return out;
+        }
+        String eventType = fbdo.eventType();
+        if (eventType == "cancel" || eventType == "auth_revoked") {
+            logger->Error(Tag::Untagged, StdString("[FirebaseOperations] stream ") + eventType.c_str());
+            RestartStream();
+            if (eventType == "auth_revoked") {
+                // Recorded as a failure too, so nothing else (e.g. pending deletes) runs on the revoked session.
+                operationFailed_ = true;
+                breaker_.Trip(millis());
+            }
+            return out;
+        }
+        if (!(eventType == "put" || eventType == "patch") || fbdo.dataType() == "null") {
+            // Keepalives and deletions (including our own cleanup) carry no commands.
+            return out;
+        }
+        StdString dataPath(fbdo.dataPath().c_str());
+        String raw = fbdo.to<String>();
+        if (dataPath == "/") {
+            // Initial snapshot, resumption replay, or multi-key patch: an object of key -> command.
+            if (AppendUnseenFromJson(raw.c_str(), raw.length(), out, max)) {
+                // The stream will not send the left-out commands again; a resumed stream replays the whole node.
+                RestartStream();
+            }
+        } else if (eventType == "put" && dataPath.find('/', 1) == StdString::npos) {
+            // A whole command written at its key. A patch here carries only the changed children, not a command.
+            StdString key = dataPath.substr(1);
+            if (seenCommandKeys_.Contains(key)) {
+                return out;
+            }
+            if (out.size() >= max) {
+                RestartStream();
+                return out;
             }
-        } */  
+            MarkSeen(key);
+            out.push_back(key + ":" + raw.c_str());
+        }
+        // Otherwise a partial update of an existing command; commands are written whole, so ignore it.
+        return out;
+    }
 
+    /** Returns up to @p max key:value pairs from one REST GET of the commands node, so the device
+     *  sees commands regardless of who wrote them. Call only while operationInProgress_ is held. */
+    Private StdVector<StdString> RetrieveCommandsFromFirebase(Size max) {
+        StdVector<StdString> out;
+        if (!sessionPool_) {
+            OnOperationError("no session pool");
+            return out;
+        }
+        Int code = sessionPool_->Send("GET", RestUrl(GetCommandsPath(), ""), nullptr, &responseBody_, &commandsEtag_);
+        readPolls_.fetch_add(1, std::memory_order_relaxed);
+        if (code == HTTP_CODE_NOT_MODIFIED) {
+            readNotModified_.fetch_add(1, std::memory_order_relaxed);
+            readBytesSaved_.fetch_add(static_cast<ULong>(lastCommandsBytes_), std::memory_order_relaxed);
+            readParseMicrosSaved_.fetch_add(lastCommandsParseMicros_, std::memory_order_relaxed);
+            return out;
+        }
+        if (code < 200 || code >= 300) {
+            commandsEtag_.clear();
+            OnOperationError(DescribeRestError(code).c_str());
+            return out;
+        }
+        lastCommandsBytes_ = responseBody_.size();
+        ULong parseStart = micros();
+        if (!responseBody_.empty() && responseBody_ != "null") {
+            if (AppendUnseenFromJson(responseBody_.data(), responseBody_.size(), out, max)) {
+                // Commands were left for the next poll; make it a full read rather than a 304.
+                commandsEtag_.clear();
+            }
+        }
+        lastCommandsParseMicros_ = micros() - parseStart;
         return out;
     }
 
     Public FirebaseOperations() = default;
 
+    /** Callers hold a shared_ptr for the duration of an operation, so none can be in flight here. */
     Public Virtual ~FirebaseOperations() override {
-        dirty_.store(true);
-        const ULong kShutdownWaitMs = 3000u;
-        ULong deadline = (ULong)millis() + kShutdownWaitMs;
-        while (operationInProgress_.load(std::memory_order_relaxed) && (ULong)millis() < deadline) {
-            delay(10);
-        }
         if (streamBegun_ || firebaseBegun) {
             Firebase.RTDB.endStream(&fbdo);
             streamBegun_ = false;
@@ -233,7 +429,7 @@ class FirebaseOperations : public IFirebaseOperations {
         }
     }
 
-    Public FirebaseOperationResult RetrieveCommands(StdVector<StdString>& out) override {
+    Public FirebaseOperationResult RetrieveCommands(StdVector<StdString>& out, Size max) override {
         out.clear();
         if (operationInProgress_.exchange(true)) {
             return FirebaseOperationResult::AnotherOperationInProgress;
@@ -242,8 +438,20 @@ class FirebaseOperations : public IFirebaseOperations {
             std::atomic<bool>& f;
             ~ClearOp() { f.store(false); }
         } guard{operationInProgress_};
-        if (!EnsureReady()) return FirebaseOperationResult::NotReady;
-        out = RetrieveCommandsFromFirebase();
+        ULong startMs = millis();
+        if (!EnsureReady(startMs)) return FirebaseOperationResult::NotReady;
+        // Every key handed out stays pending until its delete succeeds; while deletes fail, stop handing out more.
+        Size room = kMaxPendingDeletes - pendingDeleteKeys_.size();
+        if (max > room) max = room;
+#ifdef FIREBASE_COMMANDS_USE_STREAM
+        out = RetrieveCommandsFromStream(max);
+#else
+        out = RetrieveCommandsFromFirebase(max);
+#endif
+        if (!operationFailed_) {
+            FlushPendingDeletes();
+        }
+        FinishOperation(startMs);
         return FirebaseOperationResult::OperationSucceeded;
     }
 
@@ -255,43 +463,51 @@ class FirebaseOperations : public IFirebaseOperations {
             std::atomic<bool>& f;
             ~ClearOp() { f.store(false); }
         } guard{operationInProgress_};
-        if (!EnsureReady()) return FirebaseOperationResult::NotReady;
-        DynamicJsonDocument doc(16384);
-        JsonObject root = doc.to<JsonObject>();
-        for (const auto& pair : logs) {
-            const StdString& message = pair.second;
-            if (message.empty()) continue;
-            root[MillisToIso8601(pair.first).c_str()] = message.c_str();
-        }
-        if (root.size() == 0) {
+        ULong startMs = millis();
+        if (!EnsureReady(startMs)) return FirebaseOperationResult::NotReady;
+        if (!SerializeLogs(logs, logBody_)) {
+            FinishOperation(startMs);
             return FirebaseOperationResult::OperationSucceeded;
         }
-        String jsonStr;
-        serializeJson(doc, jsonStr);
-        FirebaseJson fbJson;
-        fbJson.setJsonData(jsonStr);
         time_t nowSec = time(nullptr);
         ULong nowMs = (nowSec != (time_t)-1) ? (ULong)nowSec * 1000ULL : (ULong)millis();
-        StdString uniqueKey = MillisToIso8601(nowMs);
-        StdString path = GetLogsPath() + "/" + uniqueKey;
-        if (!Firebase.RTDB.setJSON(&fbdoLog, path.c_str(), &fbJson)) {
-            const char* reason = fbdoLog.errorReason().c_str();
-            StdString msg = StdString("[FirebaseOperations] PublishLogs failed: ") + (reason && *reason ? StdString(reason) : StdString("(no reason)"));
+        Char uniqueKey[TimestampFormatter::kBufferSize];
+        Size uniqueKeyLength = FormatLogKey(nowMs, uniqueKey, sizeof(uniqueKey));
+        StdString path = GetLogsPath() + "/";
+        path.append(uniqueKey, uniqueKeyLength);
+        StdString reason;
+        if (!SendRest("PUT", path, "print=silent", &logBody_, nullptr, reason)) {
+            StdString msg = StdString("[FirebaseOperations] PublishLogs failed: ") + (reason.empty() ? StdString("(no reason)") : reason);
             logger->Error(Tag::Untagged, msg);
-            dirty_.store(true);
+            operationFailed_ = true;
+            FinishOperation(startMs);
             return FirebaseOperationResult::Failed;
         }
+        FinishOperation(startMs);
         return FirebaseOperationResult::OperationSucceeded;
     }
 
+    Public Virtual Void SoftReset() override {
+        breaker_.Reset();
+    }
+
+    Public Virtual FirebaseReadStats GetReadStats() const override {
+        return FirebaseReadStats{readPolls_.load(std::memory_order_relaxed), readNotModified_.load(std::memory_order_relaxed),
+                                 readBytesSaved_.load(std::memory_order_relaxed), readParseMicrosSaved_.load(std::memory_order_relaxed)};
+    }
+
     /** Returns true if RetrieveCommands or PublishLogs is currently running. */
     Public Virtual Bool IsOperationInProgress() const override {
         return operationInProgress_.load(std::memory_order_relaxed);
     }
 
-    /** Returns true if the instance is dirty (e.g. after an error); public methods will return default/empty until reset. */
+    /** Returns true while the circuit is open (recent failures); public methods return NotReady until it half-opens. */
     Public Virtual Bool IsDirty() const override {
-        return dirty_.load(std::memory_order_relaxed);
+        return breaker_.IsOpen(millis());
+    }
+
+    Public Virtual CircuitBreakerStats GetCircuitStats() const override {
+        return breaker_.GetStats();
     }
 };
 
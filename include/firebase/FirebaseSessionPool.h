@@ -0,0 +1,145 @@
+#ifdef ARDUINO
+#ifndef FIREBASESESSIONPOOL_H
+#define FIREBASESESSIONPOOL_H
+
+#include "IFirebaseSessionPool.h"
+#include "../common/IDnsCache.h"
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * Two sessions cover one command read and one log or delete write in flight at once, e.g. while an old
+ * FirebaseOperations finishes after a reset. Sessions idle for kIdleTimeoutMs are closed to return their
+ * TLS buffers to the heap.
+ */
+/* @Component */
+class FirebaseSessionPool : public IFirebaseSessionPool {
+    Private Static const Size kPoolSize = 2;
+    Private Static const ULong kIdleTimeoutMs = 60000;
+    Private Static const uint16_t kTimeoutMs = 10000;
+
+    Private struct Session {
+        WiFiClientSecure client;
+        HTTPClient http;
+        Bool leased = false;
+        ULong lastUsedMs = 0;
+    };
+
+    /* @Autowired */
+    Private IDnsCachePtr dnsCache_;
+
+    Private Session sessions_[kPoolSize];
+    Private mutable std::mutex mutex_;
+    Private std::atomic<ULong> requests_{0};
+    Private std::atomic<ULong> handshakes_{0};
+    Private std::atomic<ULong> exhausted_{0};
+
+    /** Leases a free session, preferring one whose connection is still open. */
+    Private Session* Acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ULong now = millis();
+        Session* chosen = nullptr;
+        for (Session& s : sessions_) {
+            if (s.leased) continue;
+            if (s.client.connected() && now - s.lastUsedMs >= kIdleTimeoutMs) {
+                s.client.stop();
+            }
+            if (!chosen || (s.client.connected() && !chosen->client.connected())) {
+                chosen = &s;
+            }
+        }
+        if (chosen) chosen->leased = true;
+        return chosen;
+    }
+
+    /**
+     * Opens @p s to the cached address of the https URL's host so HTTPClient reuses the socket instead of
+     * resolving the host itself. On any failure HTTPClient falls back to connecting by name.
+     */
+    Private Void Preconnect(Session* s, CStdString url) {
+        static const Char kScheme[] = "https://";
+        if (dnsCache_ == nullptr || url.compare(0, sizeof(kScheme) - 1, kScheme) != 0) return;
+        Size hostStart = sizeof(kScheme) - 1;
+        Size hostEnd = url.find_first_of(":/?", hostStart);
+        if (hostEnd != StdString::npos && url[hostEnd] == ':') return;
+        StdString host = url.substr(hostStart, hostEnd == StdString::npos ? StdString::npos : hostEnd - hostStart);
+        uint32_t address = 0;
+        if (!dnsCache_->Lookup(host.c_str(), address)) return;
+        if (!s->client.connect(IPAddress(address), 443, host.c_str(), nullptr, nullptr, nullptr)) {
+            dnsCache_->Invalidate(host.c_str());
+        }
+    }
+
+    Private Void Release(Session* s) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        s->lastUsedMs = millis();
+        s->leased = false;
+    }
+
+    Public FirebaseSessionPool() {
+        for (Session& s : sessions_) {
+            // Same certificate policy as the Firebase client, which is not given a CA either.
+            s.client.setInsecure();
+        }
+    }
+
+    Public Virtual ~FirebaseSessionPool() override = default;
+
+    Public Int Send(const char* method, CStdString url, const StdString* body, StdString* responseBody, StdString* etag) override {
+        Session* s = Acquire();
+        if (!s) {
+            exhausted_.fetch_add(1);
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        struct Lease { FirebaseSessionPool* pool; Session* s; ~Lease() { pool->Release(s); } } lease{this, s};
+        requests_.fetch_add(1);
+        if (!s->client.connected()) {
+            handshakes_.fetch_add(1);
+            Preconnect(s, url);
+        }
+        if (!s->http.begin(s->client, url.c_str())) {
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        s->http.setReuse(true);
+        s->http.setTimeout(kTimeoutMs);
+        if (etag) {
+            static const char* kEtagHeader[] = {"ETag"};
+            s->http.collectHeaders(kEtagHeader, 1);
+            s->http.addHeader("X-Firebase-ETag", "true");
+            if (!etag->empty()) {
+                s->http.addHeader("if-none-match", etag->c_str());
+            }
+        }
+        Int code;
+        if (body) {
+            s->http.addHeader("Content-Type", "application/json");
+            code = s->http.sendRequest(method, reinterpret_cast<uint8_t*>(const_cast<Char*>(body->data())), body->size());
+        } else {
+            code = s->http.sendRequest(method, static_cast<uint8_t*>(nullptr), 0);
+        }
+        if (etag && code == HTTP_CODE_OK) {
+            *etag = s->http.header("ETag").c_str();
+        }
+        if (responseBody) {
+            responseBody->clear();
+            if (code > 0 && code != HTTP_CODE_NOT_MODIFIED) {
+                String payload = s->http.getString();
+                responseBody->assign(payload.c_str(), payload.length());
+            }
+        }
+        s->http.end();
+        return code;
+    }
+
+    Public FirebaseSessionPoolStats GetStats() const override {
+        return FirebaseSessionPoolStats{requests_.load(), handshakes_.load(), exhausted_.load()};
+    }
+};
+
+#endif // FIREBASESESSIONPOOL_H
+#endif // ARDUINO
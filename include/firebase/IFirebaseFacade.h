@@ -3,6 +3,7 @@
 
 #include <StandardDefines.h>
 #include "IFirebaseOperations.h"
+#include "../common/BoundedMpscQueue.h"
 
 DefineStandardPointers(IFirebaseFacade)
 
@@ -21,8 +22,20 @@ class IFirebaseFacade {
 
     Public Virtual Void StartFirebaseOperations() = 0;
 
-    /** Returns true if the underlying Firebase operations instance is dirty (e.g. after an error). */
+    /** Bounds for adaptive polling: Firebase is polled every @p floorMs after a command arrives, backing off exponentially to @p ceilingMs while idle. */
+    Public Virtual Void SetPollInterval(ULong floorMs, ULong ceilingMs) = 0;
+
+    /** Capacity, depth, high-water mark and overflow drops of the pending-command queue. */
+    Public Virtual QueueStats GetCommandQueueStats() const = 0;
+
+    /** Conditional command read counters; resets keep the instance, so they cover the facade's lifetime. */
+    Public Virtual FirebaseReadStats GetReadStats() const = 0;
+
+    /** Returns true while the underlying Firebase operations circuit is open after failures. */
     Public Virtual Bool IsDirty() const = 0;
+
+    /** Circuit state, error rate and latency of the current Firebase operations instance. */
+    Public Virtual CircuitBreakerStats GetCircuitStats() const = 0;
 };
 
 #endif /* IFIREBASEFACADE_H */
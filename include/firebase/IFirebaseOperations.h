@@ -2,6 +2,7 @@
 #define IFIREBASEOPERATIONS_H
 
 #include <StandardDefines.h>
+#include "../common/CircuitBreaker.h"
 
 /** Result of a Firebase / remote-storage operation. */
 enum class FirebaseOperationResult {
@@ -12,22 +13,40 @@ enum class FirebaseOperationResult {
     NoData
 };
 
+/** Conditional command reads, cumulative. Savings are estimated from the size and parse time of the last full read. */
+struct FirebaseReadStats {
+    ULong polls;
+    ULong notModified;
+    ULong bytesSaved;
+    ULong parseMicrosSaved;
+};
+
 DefineStandardPointers(IFirebaseOperations)
 
 class IFirebaseOperations {
     Public Virtual ~IFirebaseOperations() = default;
 
-    /** Retrieves commands from Firebase. @param out Filled with list of "key:value" strings. */
-    Public Virtual FirebaseOperationResult RetrieveCommands(StdVector<StdString>& out) = 0;
+    /** Retrieves commands from Firebase. @param out Filled with at most @p max "key:value" strings; commands beyond
+     *  @p max are neither marked seen nor deleted, so a later call returns them. */
+    Public Virtual FirebaseOperationResult RetrieveCommands(StdVector<StdString>& out, Size max) = 0;
 
     /** Publish logs to Firebase at /logs. Map key = unique timestamp+seq (ULongLong), value = message. Keys are written as ISO8601. */
     Public Virtual FirebaseOperationResult PublishLogs(const StdMap<ULongLong, StdString>& logs) = 0;
 
+    /** Clears error state (closes the circuit) while keeping connections, the stream and dedup state. Safe during an operation. */
+    Public Virtual Void SoftReset() = 0;
+
+    /** Counters for the conditional (ETag) command reads made by this instance. */
+    Public Virtual FirebaseReadStats GetReadStats() const = 0;
+
     /** Returns true if RetrieveCommands or PublishLogs is currently running. */
     Public Virtual Bool IsOperationInProgress() const = 0;
 
-    /** Returns true if the instance is dirty (e.g. after an error); public methods will return default/empty until reset. */
+    /** Returns true while the circuit is open after failures; public methods return NotReady until it half-opens by itself. */
     Public Virtual Bool IsDirty() const = 0;
+
+    /** Circuit state, error rate and latency of this instance's Firebase requests. */
+    Public Virtual CircuitBreakerStats GetCircuitStats() const = 0;
 };
 
 #endif /* IFIREBASEOPERATIONS_H */
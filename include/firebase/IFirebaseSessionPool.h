@@ -0,0 +1,36 @@
+#ifndef IFIREBASESESSIONPOOL_H
+#define IFIREBASESESSIONPOOL_H
+
+#include <StandardDefines.h>
+
+/** Pool counters, cumulative since boot. */
+struct FirebaseSessionPoolStats {
+    ULong requests;
+    /** Requests that needed a new TLS session rather than reusing a kept-alive one. */
+    ULong handshakes;
+    /** Requests refused because every session was leased. */
+    ULong exhausted;
+};
+
+DefineStandardPointers(IFirebaseSessionPool)
+
+/**
+ * Keep-alive TLS sessions to the Realtime Database REST endpoint, shared by every FirebaseOperations
+ * instance so a reset does not force a cold reconnect.
+ */
+class IFirebaseSessionPool {
+    Public Virtual ~IFirebaseSessionPool() = default;
+
+    /**
+     * Sends one request on a leased session. @p body may be null for requests without one; the response
+     * body is stored in @p responseBody when it is not null.
+     * With @p etag, the response ETag is requested and stored there, and a non-empty value is sent as
+     * if-none-match so an unchanged resource answers 304 without a body.
+     * @return HTTP status, or a negative HTTPClient error code.
+     */
+    Public Virtual Int Send(const char* method, CStdString url, const StdString* body, StdString* responseBody, StdString* etag) = 0;
+
+    Public Virtual FirebaseSessionPoolStats GetStats() const = 0;
+};
+
+#endif /* IFIREBASESESSIONPOOL_H */